@@ -0,0 +1,76 @@
+#include "alloc_counter.h"
+#include "stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+void* Allocate(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    stats::RecordAllocation(size);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* AllocateNoThrow(size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    stats::RecordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+namespace benchmark {
+
+size_t AllocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace benchmark
+
+// Выровненные варианты не подменяются: в справочнике они не используются
+void* operator new(size_t size) {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return Allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return AllocateNoThrow(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return AllocateNoThrow(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace benchmark {
+
+// Число вызовов глобального operator new с начала работы программы.
+// Подсчёт включается самим фактом линковки alloc_counter.cpp в бинарник.
+size_t AllocationCount();
+
+} // namespace benchmark
@@ -0,0 +1,738 @@
+// Бенчмарк транспортного справочника на синтетическом городе.
+// Сборка из каталога benchmark:
+//   g++ -std=c++17 -O2 -I../transport-catalogue *.cpp $(ls ../transport-catalogue/*.cpp | grep -v /main.cpp) -o bench -lpthread -lz
+// Запуск:
+//   ./bench --stops=1000 --buses=200 --requests=5000 --seed=1
+//   ./bench --input=city.json      замер на готовом входном файле
+//   ./bench --dump=city.json       сохранить сгенерированный город
+//   ./bench --stats=stats.json --trace=trace.json   отчёт и trace из stats.h, без проверки бюджета аллокаций
+//   ./bench --check_allocs=0       не проверять бюджет аллокаций на запрос; по умолчанию
+//                                  превышение даёт код возврата 2
+//   ./bench --search_names=1000000 задержки StopSearch на отдельном справочнике из стольких имён
+
+#include "alloc_counter.h"
+#include "json_reader.h"
+#include "network_generator.h"
+#include "perfect_hash.h"
+#include "stats.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Func>
+double MeasureMs(Func func) {
+    const auto start = Clock::now();
+    func();
+    return ElapsedMs(start);
+}
+
+// Процентиль по ближайшему рангу, samples отсортированы
+double Percentile(const std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    const size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+size_t PeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);
+}
+
+struct RequestSamples {
+    std::vector<double> latencies;
+    std::vector<size_t> allocations;
+    std::vector<size_t> nodes;
+};
+
+size_t CountNodes(const json::Node& node) {
+    size_t count = 1;
+    if (node.IsArray()) {
+        for (const auto& item : node.AsArray()) {
+            count += CountNodes(item);
+        }
+    } else if (node.IsDict()) {
+        for (const auto& [key, value] : node.AsDict()) {
+            count += CountNodes(value);
+        }
+    }
+    return count;
+}
+
+// Бюджет аллокаций на запрос для --check_allocs: постоянная часть на поиск
+// и статистику плюс доля на каждый узел ответа. Подобран чуть выше замеров
+// на сгенерированных городах, чтобы рост числа аллокаций сразу давал код 2.
+// Map не проверяется: первый запрос рендерит карту целиком.
+struct AllocationBudget {
+    size_t base;
+    double per_node;
+
+    double For(size_t nodes) const {
+        return base + per_node * nodes;
+    }
+};
+
+std::optional<AllocationBudget> FindAllocationBudget(std::string_view type) {
+    static const std::map<std::string_view, AllocationBudget> budgets = {
+        {"Bus"sv, {6, 1.0}},
+        {"Stop"sv, {1, 1.5}},
+        {"Route"sv, {4, 1.5}},
+        {"AlternativeRoutes"sv, {16, 1.5}},
+    };
+    if (auto it = budgets.find(type); it != budgets.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::string RequestTypeName(const json_reader::Request& request) {
+    using json_reader::ObjectType;
+    using json_reader::RouteCriteria;
+
+    switch (request.type_) {
+    case ObjectType::Bus:
+        return "Bus"s;
+    case ObjectType::Stop:
+        return "Stop"s;
+    case ObjectType::Map:
+        return "Map"s;
+    case ObjectType::AlternativeRoutes:
+        return "AlternativeRoutes"s;
+    case ObjectType::NearestStops:
+        return "NearestStops"s;
+    case ObjectType::StopsInRadius:
+        return "StopsInRadius"s;
+    case ObjectType::StopSearch:
+        return request.fuzzy_ ? "StopSearch/fuzzy"s : "StopSearch/prefix"s;
+    case ObjectType::Route:
+        if (request.from_point_ || request.to_point_) {
+            return "Route/points"s;
+        }
+        if (request.departure_time_) {
+            return "Route/timetable"s;
+        }
+        if (request.criteria_ == RouteCriteria::Pareto) {
+            return "Route/pareto"s;
+        }
+        if (request.criteria_ == RouteCriteria::FewestTransfers) {
+            return "Route/fewest_transfers"s;
+        }
+        return "Route"s;
+    }
+    return "Unknown"s;
+}
+
+struct Arguments {
+    benchmark::NetworkOptions network;
+    std::string input;
+    std::string dump;
+    std::string stats;
+    std::string trace;
+    bool check_allocations = true;
+    size_t search_names = 0;
+};
+
+Arguments ParseArguments(int argc, char** argv) {
+    Arguments args;
+    benchmark::NetworkOptions& network = args.network;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (arg.rfind("--"s, 0) != 0 || eq == std::string::npos) {
+            throw std::invalid_argument("Expected --name=value, got "s + arg);
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+
+        if (name == "input"sv) {
+            args.input = value;
+        } else if (name == "dump"sv) {
+            args.dump = value;
+        } else if (name == "stats"sv) {
+            args.stats = value;
+        } else if (name == "trace"sv) {
+            args.trace = value;
+        } else if (name == "check_allocs"sv) {
+            args.check_allocations = value != "0"sv && value != "false"sv;
+        } else if (name == "stops"sv) {
+            network.stops = std::stoul(value);
+        } else if (name == "buses"sv) {
+            network.buses = std::stoul(value);
+        } else if (name == "min_route"sv) {
+            network.min_route_length = std::stoul(value);
+        } else if (name == "max_route"sv) {
+            network.max_route_length = std::stoul(value);
+        } else if (name == "ring_share"sv) {
+            network.ring_share = std::stod(value);
+        } else if (name == "extra_distances"sv) {
+            network.extra_distances = std::stoul(value);
+        } else if (name == "requests"sv) {
+            network.requests = std::stoul(value);
+        } else if (name == "bus_share"sv) {
+            network.mix.bus = std::stod(value);
+        } else if (name == "stop_share"sv) {
+            network.mix.stop = std::stod(value);
+        } else if (name == "route_share"sv) {
+            network.mix.route = std::stod(value);
+        } else if (name == "alternatives_share"sv) {
+            network.mix.alternative_routes = std::stod(value);
+        } else if (name == "map_share"sv) {
+            network.mix.map = std::stod(value);
+        } else if (name == "nearest_share"sv) {
+            network.mix.nearest_stops = std::stod(value);
+        } else if (name == "radius_share"sv) {
+            network.mix.stops_in_radius = std::stod(value);
+        } else if (name == "point_route_share"sv) {
+            network.mix.point_routes = std::stod(value);
+        } else if (name == "search_share"sv) {
+            network.mix.stop_search = std::stod(value);
+        } else if (name == "search_names"sv) {
+            args.search_names = std::stoul(value);
+        } else if (name == "routing"sv) {
+            network.routing = value != "0"sv && value != "false"sv;
+        } else if (name == "seed"sv) {
+            network.seed = static_cast<uint32_t>(std::stoul(value));
+        } else {
+            throw std::invalid_argument("Unknown option --"s + name);
+        }
+    }
+    return args;
+}
+
+struct MapUpdateTimes {
+    double full_ms = 0;
+    double distance_edit_ms = 0;
+    double route_update_ms = 0;
+    double first_bus_ms = 0;
+};
+
+// Перерисовка карты после изменений справочника через кэш фрагментов против
+// полной отрисовки. Меняет справочник, поэтому вызывается после всех запросов.
+// Каждый результат сверяется с полной отрисовкой
+MapUpdateTimes MeasureMapUpdates(const json_reader::JsonReader& reader, transport::TransportCatalogue& catalogue,
+                                 uint32_t seed) {
+    MapUpdateTimes result;
+    const auto& buses = catalogue.GetAllBuses();
+    if (buses.empty()) {
+        return result;
+    }
+    const auto rerender = [&](std::string_view scenario) {
+        const double ms = MeasureMs([&] { reader.GetRenderedMap(); });
+        if (*reader.GetRenderedMap() != reader.RenderMap()) {
+            throw std::logic_error("Incremental map differs from full render: "s + std::string(scenario));
+        }
+        return ms;
+    };
+
+    reader.GetRenderedMap();
+    result.full_ms = MeasureMs([&] { reader.RenderMap(); });
+
+    // Версия справочника меняется, но ни один маршрут и ни одна остановка не перерисовываются
+    const transport::Stop* first_stop = &catalogue.GetAllStops().front();
+    catalogue.SetStopDistance(first_stop, first_stop, catalogue.GetStopDistance(first_stop, first_stop));
+    result.distance_edit_ms = rerender("distance edit"sv);
+
+    std::mt19937 random(seed);
+    const auto forward_stops = [&catalogue](const transport::Bus& bus) {
+        std::vector<const transport::Stop*> stops;
+        for (transport::StopId stop : catalogue.GetForwardRoute(bus.GetId())) {
+            stops.push_back(catalogue.GetStopById(stop));
+        }
+        return stops;
+    };
+    const transport::Bus& updated = buses[random() % buses.size()];
+    std::vector<const transport::Stop*> reversed = forward_stops(updated);
+    std::reverse(reversed.begin(), reversed.end());
+    catalogue.UpdateBus(updated.GetName(), reversed, updated.is_round() ? transport::Type::RING : transport::Type::NONRING);
+    result.route_update_ms = rerender("route update"sv);
+
+    // Новый первый по алфавиту автобус сдвигает цвета всех остальных
+    const transport::Bus& copied = buses[random() % buses.size()];
+    catalogue.AddBus(" " + copied.GetName(), forward_stops(copied), transport::Type::RING);
+    result.first_bus_ms = rerender("first bus"sv);
+    return result;
+}
+
+// Маршрут между точками не может пройти пешком через остановку без поездки:
+// точки в 1500 м друг от друга при пределе 1000 м, остановка A посередине.
+// Ответ должен быть таким же, как без остановок рядом, — не найден
+void CheckPointRouteWalkCap() {
+    transport::TransportCatalogue catalogue;
+    catalogue.AddStop("A"s, {55.0, 37.0});
+    catalogue.AddStop("B"s, {55.05, 37.0});
+    catalogue.SetStopDistance("A"sv, "B"sv, 5600);
+    catalogue.AddBus("1"s, {catalogue.GetStop("A"sv), catalogue.GetStop("B"sv)}, transport::Type::NONRING);
+
+    transport::RoutingSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40;
+    const transport::TransportRouter router(catalogue, settings);
+    const transport::StopIndex stops(catalogue);
+    if (router.FindRoute({54.99325, 37.0}, {55.00675, 37.0}, stops)
+        || router.FindRoute({54.99325, 37.1}, {55.00675, 37.1}, stops)) {
+        throw std::logic_error("Point route walks farther than max_walking_distance");
+    }
+    // От A до B с поездкой маршрут есть: пешком, ожидание, автобус, пешком
+    const auto ride = router.FindRoute({54.99325, 37.0}, {55.05, 37.001}, stops);
+    if (!ride || ride->items.size() != 4 || !std::holds_alternative<transport::RouteInfo::BusItem>(ride->items[2])) {
+        throw std::logic_error("Point route through a bus is missing");
+    }
+}
+
+struct AlternativeSamples {
+    // Задержки в микросекундах: один поиск Дейкстры, k = 1 и k = 3 для одних и тех же пар
+    std::vector<double> dijkstra;
+    std::vector<double> single;
+    std::vector<double> triple;
+};
+
+// Цель запроса AlternativeRoutes: k = 3 заметно дешевле трёх поисков от того же начала
+AlternativeSamples MeasureAlternatives(const transport::TransportRouter& router,
+                                       const transport::TransportCatalogue& catalogue, uint32_t seed) {
+    constexpr size_t PAIRS = 200;
+
+    AlternativeSamples result;
+    const auto& stops = catalogue.GetAllStops();
+    if (stops.empty()) {
+        return result;
+    }
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<size_t> any_stop(0, stops.size() - 1);
+    for (size_t i = 0; i < PAIRS; ++i) {
+        const std::string_view from = stops[any_stop(random)].name_;
+        const std::string_view to = stops[any_stop(random)].name_;
+        if (from == to || !router.FindRoute(from, to)) {
+            continue;
+        }
+        result.dijkstra.push_back(MeasureMs([&] { router.FindRouteByDijkstra(from, to); }) * 1000.0);
+        result.single.push_back(MeasureMs([&] { router.FindAlternativeRoutes(from, to, 1); }) * 1000.0);
+        result.triple.push_back(MeasureMs([&] { router.FindAlternativeRoutes(from, to, 3); }) * 1000.0);
+    }
+    return result;
+}
+
+struct NameLookupTimes {
+    size_t count = 0;
+    double hash_map_ms = 0;
+    double frozen_ms = 0;
+    double reload_ms = 0;
+};
+
+// Хеш имён остановок после Serialize и Deserialize должен давать те же номера,
+// а обрезанные или испорченные данные — отвергаться
+double CheckPerfectHashRoundTrip(const std::vector<std::string_view>& names) {
+    const transport::PerfectHash hash(names);
+    std::optional<transport::PerfectHash> loaded;
+    std::string data;
+    const double ms = MeasureMs([&] {
+        std::ostringstream out;
+        hash.Serialize(out);
+        data = out.str();
+        std::istringstream in(data);
+        loaded.emplace(transport::PerfectHash::Deserialize(in));
+    });
+    if (loaded->Size() != hash.Size()) {
+        throw std::logic_error("PerfectHash round trip changed size");
+    }
+    for (std::string_view name : names) {
+        if ((*loaded)(name) != hash(name)) {
+            throw std::logic_error("PerfectHash round trip changed slots");
+        }
+    }
+
+    const auto rejects = [](std::string corrupted) {
+        std::istringstream in(corrupted);
+        try {
+            transport::PerfectHash::Deserialize(in);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    // Заголовок — три uint64_t, за ним смещения корзин
+    constexpr size_t HEADER_SIZE = 3 * sizeof(uint64_t);
+    if (data.size() > HEADER_SIZE) {
+        std::string bad_slot = data;
+        const int32_t outside = -static_cast<int32_t>(hash.Size()) - 1;
+        std::copy_n(reinterpret_cast<const char*>(&outside), sizeof(outside), bad_slot.begin() + HEADER_SIZE);
+        if (!rejects(data.substr(0, data.size() - 1)) || !rejects(bad_slot)) {
+            throw std::logic_error("PerfectHash accepted corrupted data");
+        }
+    }
+    return ms;
+}
+
+// Поиск остановок и автобусов по имени: прежние unordered_map против
+// замороженных таблиц справочника. Каждый десятый запрос — промах
+NameLookupTimes MeasureNameLookups(const transport::TransportCatalogue& catalogue, uint32_t seed) {
+    constexpr size_t LOOKUPS = 1'000'000;
+
+    std::unordered_map<std::string_view, const transport::Stop*> stops;
+    std::unordered_map<std::string_view, const transport::Bus*> buses;
+    std::vector<std::string> names;
+    for (const auto& stop : catalogue.GetAllStops()) {
+        stops.emplace(stop.name_, &stop);
+        names.emplace_back(stop.name_);
+    }
+    std::vector<std::string_view> stop_names;
+    stop_names.reserve(stops.size());
+    for (const auto& [name, stop] : stops) {
+        stop_names.push_back(name);
+    }
+    for (const auto& bus : catalogue.GetAllBuses()) {
+        buses.emplace(bus.GetName(), &bus);
+        names.push_back(bus.GetName());
+    }
+    NameLookupTimes result;
+    result.reload_ms = CheckPerfectHashRoundTrip(stop_names);
+    if (names.empty()) {
+        return result;
+    }
+
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<size_t> any_name(0, names.size() - 1);
+    std::vector<std::string> queries;
+    queries.reserve(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        queries.push_back(i % 10 == 9 ? "Missing "s + std::to_string(i) : names[any_name(random)]);
+    }
+
+    size_t hash_map_found = 0;
+    result.hash_map_ms = MeasureMs([&] {
+        for (const auto& name : queries) {
+            hash_map_found += stops.count(name) + buses.count(name);
+        }
+    });
+    size_t frozen_found = 0;
+    result.frozen_ms = MeasureMs([&] {
+        for (const auto& name : queries) {
+            frozen_found += (catalogue.GetStop(name) != nullptr) + (catalogue.GetBus(name) != nullptr);
+        }
+    });
+    if (hash_map_found != frozen_found) {
+        throw std::logic_error("Name tables disagree");
+    }
+    result.count = queries.size();
+    return result;
+}
+
+struct StopSearchSamples {
+    size_t names = 0;
+    double build_ms = 0;
+    // Задержки в микросекундах по режимам поиска
+    std::map<std::string, std::vector<double>> latencies;
+};
+
+// Имена из двух-трёх слов случайного словаря, иногда с номером, как у настоящих остановок
+std::vector<std::string> GenerateStopNames(size_t count, std::mt19937& random) {
+    static const std::vector<std::string_view> syllables = {
+        "ка"sv, "ли"sv, "но"sv, "ва"sv, "ро"sv, "ми"sv, "ту"sv, "ле"sv, "са"sv, "да"sv,
+        "ne"sv, "ri"sv, "vo"sv, "la"sv, "to"sv, "mar"sv, "ken"sv, "bu"sv, "sel"sv, "ost"sv
+    };
+    std::vector<std::string> words(2000);
+    for (auto& word : words) {
+        const size_t length = 2 + random() % 3;
+        for (size_t i = 0; i < length; ++i) {
+            word += syllables[random() % syllables.size()];
+        }
+        word[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(word[0])));
+    }
+
+    std::unordered_set<std::string> used;
+    std::vector<std::string> names;
+    names.reserve(count);
+    while (names.size() < count) {
+        std::string name = words[random() % words.size()] + ' ' + words[random() % words.size()];
+        if (random() % 3 == 0) {
+            name += ' ' + words[random() % words.size()];
+        }
+        if (random() % 4 == 0) {
+            name += ' ' + std::to_string(random() % 100);
+        }
+        if (used.insert(name).second) {
+            names.push_back(std::move(name));
+        }
+    }
+    return names;
+}
+
+// StopSearch на справочнике из одних остановок: префиксы существующих имён
+// и имена с одной случайной опечаткой
+StopSearchSamples MeasureStopSearch(size_t count, uint32_t seed) {
+    constexpr size_t QUERIES = 2000;
+    constexpr size_t LIMIT = 10;
+
+    std::mt19937 random(seed);
+    StopSearchSamples result;
+    std::vector<std::string> names = GenerateStopNames(count, random);
+    transport::TransportCatalogue catalogue;
+    for (auto& name : names) {
+        catalogue.AddStop(name, {0, 0});
+    }
+
+    std::optional<transport::StopNameIndex> index;
+    result.build_ms = MeasureMs([&] { index.emplace(catalogue); });
+    result.names = index->Size();
+
+    std::uniform_int_distribution<size_t> any_name(0, names.size() - 1);
+    for (size_t i = 0; i < QUERIES; ++i) {
+        const std::string& name = names[any_name(random)];
+        const std::string prefix = name.substr(0, 1 + random() % std::min<size_t>(name.size(), 8));
+        std::string typo = name;
+        typo[random() % typo.size()] = 'x';
+
+        size_t found = 0;
+        const auto start = Clock::now();
+        found += index->FindByPrefix(prefix, LIMIT).size();
+        result.latencies["prefix"s].push_back(ElapsedMs(start) * 1000.0);
+        for (int edits : {1, 2}) {
+            const auto fuzzy_start = Clock::now();
+            found += index->FindSimilar(typo, edits, LIMIT).size();
+            result.latencies["fuzzy, max_edits "s + std::to_string(edits)].push_back(ElapsedMs(fuzzy_start) * 1000.0);
+        }
+        if (found == 0) {
+            throw std::logic_error("StopSearch found nothing for "s + name);
+        }
+    }
+    return result;
+}
+
+void PrintPhase(std::ostream& out, std::string_view name, double ms, std::string_view note = {}) {
+    out << "  " << std::left << std::setw(24) << name << std::right << std::setw(12) << ms << " ms";
+    if (!note.empty()) {
+        out << "  " << note;
+    }
+    out << '\n';
+}
+
+// false, если превышен бюджет аллокаций
+bool Run(const Arguments& args, std::ostream& out) {
+    out << std::fixed << std::setprecision(2);
+    // Сбор stats сам выделяет память внутри запросов, бюджет с ним не сравним
+    bool check_allocations = args.check_allocations;
+    if (!args.stats.empty() || !args.trace.empty()) {
+        stats::Enable(!args.trace.empty());
+        check_allocations = false;
+    }
+
+    std::string text;
+    if (!args.input.empty()) {
+        std::ifstream input(args.input);
+        if (!input) {
+            throw std::runtime_error("Cannot open "s + args.input);
+        }
+        text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    } else {
+        std::optional<json::Document> generated;
+        const double generate_ms = MeasureMs([&] {
+            generated.emplace(benchmark::GenerateNetwork(args.network));
+        });
+        std::ostringstream serialized;
+        json::Print(*generated, serialized);
+        text = serialized.str();
+
+        const auto& network = args.network;
+        out << "network: " << network.stops << " stops, " << network.buses << " buses, route length "
+            << network.min_route_length << ".." << network.max_route_length << ", ring share "
+            << network.ring_share << ", " << network.requests << " requests, seed " << network.seed << '\n';
+        PrintPhase(out, "generate"sv, generate_ms);
+    }
+    if (!args.dump.empty()) {
+        std::ofstream(args.dump) << text;
+    }
+
+    std::istringstream input(text);
+    std::optional<json::Document> document;
+    const double load_ms = MeasureMs([&] {
+        document.emplace(json::Load(input));
+    });
+    const json::Dict& root = document->GetRoot().AsDict();
+
+    transport::TransportCatalogue catalogue;
+    std::istringstream unused_input;
+    std::ostringstream unused_output;
+    json_reader::JsonReader reader(unused_input, unused_output, catalogue);
+
+    CheckPointRouteWalkCap();
+    const double base_ms = MeasureMs([&] { reader.ReadBase(root); });
+    const NameLookupTimes lookup = MeasureNameLookups(catalogue, args.network.seed);
+    const double routers_ms = MeasureMs([&] { reader.BuildRouters(); });
+    const double requests_ms = MeasureMs([&] { reader.ReadRequests(root); });
+    const double map_ms = MeasureMs([&] { reader.RenderMap(); });
+
+    std::map<std::string, RequestSamples> samples_by_type;
+    json::Array answers;
+    answers.reserve(reader.GetRequests().size());
+    const double answer_ms = MeasureMs([&] {
+        for (const auto& request : reader.GetRequests()) {
+            RequestSamples& samples = samples_by_type[RequestTypeName(request)];
+            const size_t allocations_before = benchmark::AllocationCount();
+            const auto start = Clock::now();
+            answers.emplace_back(reader.AnswerRequest(request));
+            samples.latencies.push_back(ElapsedMs(start) * 1000.0);
+            samples.allocations.push_back(benchmark::AllocationCount() - allocations_before);
+            samples.nodes.push_back(CountNodes(answers.back()));
+        }
+    });
+
+    std::ostringstream printed;
+    const double print_ms = MeasureMs([&] {
+        json::Print(json::Document(std::move(answers)), printed);
+    });
+    // Тот же набор ответов потоковой записью, как в основной программе
+    const double stream_ms = MeasureMs([&] { reader.AnswerToRequests(); });
+    AlternativeSamples alternatives;
+    if (const auto router = reader.GetRouter()) {
+        alternatives = MeasureAlternatives(*router, catalogue, args.network.seed);
+    }
+    const MapUpdateTimes map_update = MeasureMapUpdates(reader, catalogue, args.network.seed);
+
+    const double megabytes = text.size() / (1024.0 * 1024.0);
+    std::ostringstream load_note;
+    load_note << std::fixed << std::setprecision(2) << megabytes << " MB, " << megabytes / (load_ms / 1000.0) << " MB/s";
+
+    out << "phases:\n";
+    PrintPhase(out, "json load"sv, load_ms, load_note.str());
+    PrintPhase(out, "catalogue build"sv, base_ms);
+    std::ostringstream lookup_note;
+    lookup_note << std::fixed << std::setprecision(1) << lookup.hash_map_ms * 1e6 / lookup.count << " ns/lookup";
+    PrintPhase(out, "names: unordered_map"sv, lookup.hash_map_ms, lookup_note.str());
+    lookup_note.str({});
+    lookup_note << lookup.frozen_ms * 1e6 / lookup.count << " ns/lookup";
+    PrintPhase(out, "names: perfect hash"sv, lookup.frozen_ms, lookup_note.str());
+    PrintPhase(out, "names: hash reload"sv, lookup.reload_ms, "Serialize + Deserialize"sv);
+    PrintPhase(out, "router build"sv, routers_ms);
+    PrintPhase(out, "read requests"sv, requests_ms);
+    PrintPhase(out, "map render (cold)"sv, map_ms);
+    PrintPhase(out, "answer requests"sv, answer_ms);
+    PrintPhase(out, "print responses"sv, print_ms);
+    PrintPhase(out, "answer + write (stream)"sv, stream_ms, "json::Writer, без дерева Node"sv);
+    PrintPhase(out, "map: full render"sv, map_update.full_ms, "без кэша фрагментов"sv);
+    PrintPhase(out, "map: distance edit"sv, map_update.distance_edit_ms, "ничего не перерисовано"sv);
+    PrintPhase(out, "map: route updated"sv, map_update.route_update_ms, "UpdateBus одного маршрута"sv);
+    PrintPhase(out, "map: bus added first"sv, map_update.first_bus_ms, "сдвинуты все цвета"sv);
+
+    out << "requests (latency in us):\n";
+    out << "  " << std::left << std::setw(24) << "type" << std::right
+        << std::setw(8) << "count" << std::setw(12) << "req/s"
+        << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(12) << "max"
+        << std::setw(12) << "allocs/req" << std::setw(13) << "allocs/node" << '\n';
+    bool over_budget = false;
+    for (auto& [type, samples] : samples_by_type) {
+        auto& latencies = samples.latencies;
+        std::sort(latencies.begin(), latencies.end());
+        double total_us = 0;
+        for (double sample : latencies) {
+            total_us += sample;
+        }
+        size_t total_allocations = 0;
+        double max_per_node = 0;
+        const auto budget = FindAllocationBudget(type);
+        for (size_t i = 0; i < samples.allocations.size(); ++i) {
+            total_allocations += samples.allocations[i];
+            max_per_node = std::max(max_per_node, static_cast<double>(samples.allocations[i]) / samples.nodes[i]);
+            if (check_allocations && budget && samples.allocations[i] > budget->For(samples.nodes[i])) {
+                std::cerr << type << ": " << samples.allocations[i] << " allocations for " << samples.nodes[i]
+                          << " response nodes, budget " << budget->For(samples.nodes[i]) << '\n';
+                over_budget = true;
+            }
+        }
+        out << "  " << std::left << std::setw(24) << type << std::right
+            << std::setw(8) << latencies.size()
+            << std::setw(12) << (total_us > 0 ? latencies.size() / (total_us / 1e6) : 0.0)
+            << std::setw(10) << Percentile(latencies, 50) << std::setw(10) << Percentile(latencies, 90)
+            << std::setw(10) << Percentile(latencies, 99) << std::setw(12) << latencies.back()
+            << std::setw(12) << static_cast<double>(total_allocations) / latencies.size()
+            << std::setw(13) << max_per_node << '\n';
+    }
+
+    if (alternatives.dijkstra.size() > 0) {
+        out << "alternative routes over " << alternatives.dijkstra.size() << " stop pairs (latency in us):\n";
+        out << "  " << std::left << std::setw(24) << "search" << std::right
+            << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << '\n';
+        const std::pair<std::string_view, std::vector<double>*> rows[] = {
+            {"one Dijkstra"sv, &alternatives.dijkstra},
+            {"k = 1 (precomputed)"sv, &alternatives.single},
+            {"k = 3"sv, &alternatives.triple},
+        };
+        for (const auto& [name, latencies] : rows) {
+            std::sort(latencies->begin(), latencies->end());
+            out << "  " << std::left << std::setw(24) << name << std::right
+                << std::setw(10) << Percentile(*latencies, 50) << std::setw(10) << Percentile(*latencies, 90)
+                << std::setw(10) << Percentile(*latencies, 99) << '\n';
+        }
+        out << "  k = 3 / one Dijkstra at p50: "
+            << Percentile(alternatives.triple, 50) / Percentile(alternatives.dijkstra, 50) << "x, target < 3x\n";
+    }
+
+    if (args.search_names > 0) {
+        StopSearchSamples search = MeasureStopSearch(args.search_names, args.network.seed);
+        out << "stop search over " << search.names << " names (latency in us), index build "
+            << search.build_ms << " ms:\n";
+        out << "  " << std::left << std::setw(24) << "mode" << std::right << std::setw(8) << "count"
+            << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(12) << "max" << '\n';
+        for (auto& [mode, latencies] : search.latencies) {
+            std::sort(latencies.begin(), latencies.end());
+            out << "  " << std::left << std::setw(24) << mode << std::right << std::setw(8) << latencies.size()
+                << std::setw(10) << Percentile(latencies, 50) << std::setw(10) << Percentile(latencies, 90)
+                << std::setw(10) << Percentile(latencies, 99) << std::setw(12) << latencies.back() << '\n';
+        }
+    }
+
+    out << "peak RSS: " << PeakRssKb() / 1024.0 << " MB\n";
+
+    if (!args.stats.empty()) {
+        std::ofstream stats_out(args.stats);
+        stats::WriteReport(stats_out);
+    }
+    if (!args.trace.empty()) {
+        std::ofstream trace_out(args.trace);
+        stats::WriteTrace(trace_out);
+    }
+    return !over_budget;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        if (!Run(ParseArguments(argc, argv), std::cout)) {
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "network_generator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace benchmark {
+
+namespace {
+    constexpr double MIN_LAT = 55.5;
+    constexpr double MAX_LAT = 55.9;
+    constexpr double MIN_LNG = 37.3;
+    constexpr double MAX_LNG = 37.9;
+    constexpr int MIN_DISTANCE = 200;
+    constexpr int MAX_DISTANCE = 3000;
+    constexpr int ALTERNATIVE_COUNT = 3;
+    constexpr int NEARBY_COUNT = 5;
+    constexpr double NEARBY_RADIUS = 500.0;
+
+    std::string StopName(size_t index) {
+        return "Stop "s + std::to_string(index);
+    }
+
+    std::string BusName(size_t index) {
+        return "Bus "s + std::to_string(index);
+    }
+
+    json::Dict MakeRenderSettings() {
+        return json::Dict{
+            {"width"s, 1200.0},
+            {"height"s, 1200.0},
+            {"padding"s, 50.0},
+            {"line_width"s, 14.0},
+            {"stop_radius"s, 5.0},
+            {"bus_label_font_size"s, 20},
+            {"bus_label_offset"s, json::Array{7.0, 15.0}},
+            {"stop_label_font_size"s, 20},
+            {"stop_label_offset"s, json::Array{7.0, -3.0}},
+            {"underlayer_color"s, json::Array{255, 255, 255, 0.85}},
+            {"underlayer_width"s, 3.0},
+            {"color_palette"s, json::Array{"green"s, json::Array{255, 160, 0}, "red"s}}
+        };
+    }
+}
+
+json::Document GenerateNetwork(const NetworkOptions& options) {
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<double> lat(MIN_LAT, MAX_LAT);
+    std::uniform_real_distribution<double> lng(MIN_LNG, MAX_LNG);
+    std::uniform_int_distribution<int> distance(MIN_DISTANCE, MAX_DISTANCE);
+    std::uniform_int_distribution<size_t> any_stop(0, std::max<size_t>(options.stops, 1) - 1);
+    std::uniform_int_distribution<size_t> any_bus(0, std::max<size_t>(options.buses, 1) - 1);
+    std::uniform_int_distribution<size_t> route_length(
+        std::max<size_t>(options.min_route_length, 2), std::max(options.min_route_length, options.max_route_length));
+    std::bernoulli_distribution ring(options.ring_share);
+
+    std::vector<json::Dict> distances(options.stops);
+    for (size_t stop = 0; stop < options.stops; ++stop) {
+        for (size_t i = 0; i < options.extra_distances; ++i) {
+            distances[stop][StopName(any_stop(random))] = distance(random);
+        }
+    }
+
+    json::Array buses;
+    buses.reserve(options.buses);
+    for (size_t bus = 0; options.stops > 0 && bus < options.buses; ++bus) {
+        const bool is_ring = ring(random);
+        json::Array stops;
+        size_t prev = any_stop(random);
+        const size_t first = prev;
+        stops.push_back(StopName(prev));
+        for (size_t length = route_length(random); stops.size() < length;) {
+            const size_t next = any_stop(random);
+            distances[prev].emplace(StopName(next), distance(random));
+            stops.push_back(StopName(next));
+            prev = next;
+        }
+        if (is_ring) {
+            distances[prev].emplace(StopName(first), distance(random));
+            stops.push_back(StopName(first));
+        }
+        buses.push_back(json::Dict{
+            {"type"s, "Bus"s},
+            {"name"s, BusName(bus)},
+            {"stops"s, std::move(stops)},
+            {"is_roundtrip"s, is_ring}
+        });
+    }
+
+    json::Array base_requests;
+    base_requests.reserve(options.stops + buses.size());
+    for (size_t stop = 0; stop < options.stops; ++stop) {
+        base_requests.push_back(json::Dict{
+            {"type"s, "Stop"s},
+            {"name"s, StopName(stop)},
+            {"latitude"s, lat(random)},
+            {"longitude"s, lng(random)},
+            {"road_distances"s, std::move(distances[stop])}
+        });
+    }
+    std::move(buses.begin(), buses.end(), std::back_inserter(base_requests));
+
+    const RequestMix& mix = options.mix;
+    std::discrete_distribution<int> request_type{mix.bus, mix.stop, mix.route, mix.alternative_routes, mix.map,
+                                                 mix.nearest_stops, mix.stops_in_radius, mix.point_routes, mix.stop_search};
+
+    json::Array stat_requests;
+    stat_requests.reserve(options.requests);
+    for (size_t id = 0; id < options.requests; ++id) {
+        json::Dict request{{"id"s, static_cast<int>(id)}};
+        switch (request_type(random)) {
+        case 0:
+            request["type"s] = "Bus"s;
+            request["name"s] = BusName(any_bus(random));
+            break;
+        case 1:
+            request["type"s] = "Stop"s;
+            request["name"s] = StopName(any_stop(random));
+            break;
+        case 2:
+            request["type"s] = "Route"s;
+            request["from"s] = StopName(any_stop(random));
+            request["to"s] = StopName(any_stop(random));
+            break;
+        case 3:
+            request["type"s] = "AlternativeRoutes"s;
+            request["from"s] = StopName(any_stop(random));
+            request["to"s] = StopName(any_stop(random));
+            request["count"s] = ALTERNATIVE_COUNT;
+            break;
+        case 4:
+            request["type"s] = "Map"s;
+            break;
+        case 5:
+            request["type"s] = "NearestStops"s;
+            request["latitude"s] = lat(random);
+            request["longitude"s] = lng(random);
+            request["count"s] = NEARBY_COUNT;
+            break;
+        case 6:
+            request["type"s] = "StopsInRadius"s;
+            request["latitude"s] = lat(random);
+            request["longitude"s] = lng(random);
+            request["radius"s] = NEARBY_RADIUS;
+            break;
+        case 7:
+            request["type"s] = "Route"s;
+            request["from"s] = json::Dict{{"latitude"s, lat(random)}, {"longitude"s, lng(random)}};
+            request["to"s] = json::Dict{{"latitude"s, lat(random)}, {"longitude"s, lng(random)}};
+            break;
+        default: {
+            // Половина — начало имени, половина — имя с одной опечаткой
+            std::string query = StopName(any_stop(random));
+            request["type"s] = "StopSearch"s;
+            if (random() % 2 == 0) {
+                query.resize(1 + random() % query.size());
+            } else {
+                query[random() % query.size()] = 'x';
+                request["mode"s] = "fuzzy"s;
+            }
+            request["query"s] = std::move(query);
+            break;
+        }
+        }
+        stat_requests.push_back(std::move(request));
+    }
+
+    json::Dict root{
+        {"base_requests"s, std::move(base_requests)},
+        {"render_settings"s, MakeRenderSettings()},
+        {"stat_requests"s, std::move(stat_requests)}
+    };
+    if (options.routing) {
+        root["routing_settings"s] = json::Dict{{"bus_wait_time"s, 6}, {"bus_velocity"s, 40.0}};
+    }
+    return json::Document(std::move(root));
+}
+
+} // namespace benchmark
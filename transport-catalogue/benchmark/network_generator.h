@@ -0,0 +1,43 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+
+namespace benchmark {
+
+// Доли запросов каждого типа, нормировать не обязательно
+struct RequestMix {
+    double bus = 0.3;
+    double stop = 0.3;
+    double route = 0.3;
+    double alternative_routes = 0.05;
+    double map = 0.05;
+    double nearest_stops = 0;
+    double stops_in_radius = 0;
+    // Route между произвольными точками
+    double point_routes = 0;
+    // StopSearch по префиксу и с опечатками
+    double stop_search = 0;
+};
+
+// Параметры синтетического города
+struct NetworkOptions {
+    size_t stops = 300;
+    size_t buses = 60;
+    size_t min_route_length = 5;
+    size_t max_route_length = 25;
+    double ring_share = 0.4;
+    // Дополнительные расстояния от остановки до случайных соседей, помимо соседей по маршрутам
+    size_t extra_distances = 2;
+    size_t requests = 2000;
+    RequestMix mix;
+    bool routing = true;
+    uint32_t seed = 42;
+};
+
+// Входной документ в формате main.cpp: base_requests, render_settings,
+// routing_settings и stat_requests. При одинаковых параметрах результат одинаков
+json::Document GenerateNetwork(const NetworkOptions& options);
+
+} // namespace benchmark
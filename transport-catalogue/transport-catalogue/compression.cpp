@@ -0,0 +1,84 @@
+#include "compression.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+using namespace std::literals;
+
+namespace compression {
+
+namespace {
+    constexpr int WINDOW_BITS = 15;
+    constexpr int GZIP_HEADER_BITS = 16;
+    constexpr int MEMORY_LEVEL = 8;
+}
+
+std::string_view ToString(Encoding encoding) {
+    return encoding == Encoding::GZIP ? "gzip"sv : "deflate"sv;
+}
+
+std::string Compress(std::string_view data, Encoding encoding) {
+    z_stream stream{};
+    const int window_bits = encoding == Encoding::GZIP ? WINDOW_BITS + GZIP_HEADER_BITS : WINDOW_BITS;
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw CompressionError("deflateInit2 failed"s);
+    }
+
+    std::string result(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+
+    // avail_in и avail_out — 32-битные, поэтому большие строки подаём частями
+    int status = Z_OK;
+    size_t consumed = 0;
+    while (status == Z_OK) {
+        const size_t chunk = std::min<size_t>(data.size() - consumed, UINT_MAX);
+        stream.avail_in = static_cast<uInt>(chunk);
+        stream.avail_out = static_cast<uInt>(std::min<size_t>(result.size() - stream.total_out, UINT_MAX));
+        const bool last = consumed + chunk == data.size();
+        status = deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+        consumed += chunk - stream.avail_in;
+    }
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) {
+        throw CompressionError("deflate failed"s);
+    }
+    result.resize(stream.total_out);
+    return result;
+}
+
+std::string EncodeBase64(std::string_view data) {
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    result.reserve((data.size() + 2) / 3 * 4);
+
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        const uint32_t triple = (static_cast<unsigned char>(data[i]) << 16)
+                              | (static_cast<unsigned char>(data[i + 1]) << 8)
+                              | static_cast<unsigned char>(data[i + 2]);
+        result.push_back(ALPHABET[(triple >> 18) & 0x3F]);
+        result.push_back(ALPHABET[(triple >> 12) & 0x3F]);
+        result.push_back(ALPHABET[(triple >> 6) & 0x3F]);
+        result.push_back(ALPHABET[triple & 0x3F]);
+    }
+
+    if (const size_t rest = data.size() - i; rest > 0) {
+        uint32_t triple = static_cast<unsigned char>(data[i]) << 16;
+        if (rest == 2) {
+            triple |= static_cast<unsigned char>(data[i + 1]) << 8;
+        }
+        result.push_back(ALPHABET[(triple >> 18) & 0x3F]);
+        result.push_back(ALPHABET[(triple >> 12) & 0x3F]);
+        result.push_back(rest == 2 ? ALPHABET[(triple >> 6) & 0x3F] : '=');
+        result.push_back('=');
+    }
+    return result;
+}
+
+} // namespace compression
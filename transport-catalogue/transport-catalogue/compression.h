@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Сжатие ответов через zlib (при сборке нужен -lz)
+namespace compression {
+
+enum class Encoding {
+    GZIP,       // формат gzip, как Content-Encoding: gzip
+    DEFLATE     // поток zlib, как Content-Encoding: deflate
+};
+
+constexpr size_t ENCODING_COUNT = 2;
+
+class CompressionError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+std::string_view ToString(Encoding encoding);
+
+std::string Compress(std::string_view data, Encoding encoding);
+std::string EncodeBase64(std::string_view data);
+
+} // namespace compression
@@ -1,12 +1,11 @@
 
-#include <unordered_set>
+#include <algorithm>
 #include "transport_catalogue.h"
 
 using namespace transport;
 
-Stop::Stop(std::string name, geo::Coordinates(coordinates))
-    : name_(std::move(name))
-    , coordinates_(coordinates)
+Stop::Stop(std::string_view name)
+    : name_(name)
 {
 }
 
@@ -19,52 +18,55 @@ BusInfo::BusInfo(std::string id, size_t total_stops, size_t unique, int length,
 {
 }
 
-Bus::Bus(std::string name, std::vector<const Stop*> stops, Type type)
+Bus::Bus(std::string name, Type type)
     : name_(std::move(name))
-    , stops_(std::move(stops))
     , type_(type)
 {
 }
 
 BusInfo Bus::GetInfo(const TransportCatalogue& catalogue) const {
-    double curvature = double(GetRealLength(catalogue)) / double(GetGeographicalLength());
-    return BusInfo(name_, GetCountOfStops(), GetUniqueCount(), GetRealLength(catalogue), curvature);
+    double curvature = double(GetRealLength(catalogue)) / double(GetGeographicalLength(catalogue));
+    return BusInfo(name_, GetCountOfStops(catalogue), GetUniqueCount(catalogue), GetRealLength(catalogue), curvature);
 }
 
-const std::vector<const Stop*>& Bus::GetStops() const {
-    return stops_;
+const std::string& Bus::GetName() const {
+    return name_;
 }
 
-std::string Bus::GetName() const {
-    return name_;
+BusId Bus::GetId() const {
+    return id_;
 }
 
-size_t Bus::GetCountOfStops() const {
-    return stops_.size();
+size_t Bus::GetCountOfStops(const TransportCatalogue& catalogue) const {
+    return catalogue.GetRoute(id_).size();
 }
 
 double Bus::GetRealLength(const TransportCatalogue& catalogue) const {
+    const auto route = catalogue.GetRoute(id_);
     double len = 0;
-    for (size_t i = 0; i < stops_.size() - 1; ++i) {
-        len += catalogue.GetStopDistance(stops_[i], stops_[i + 1]);
+    for (size_t i = 0; i + 1 < route.size(); ++i) {
+        len += catalogue.GetStopDistance(catalogue.GetStopById(route[i]), catalogue.GetStopById(route[i + 1]));
     }
     return len;
 }
 
-double Bus::GetGeographicalLength() const {
+double Bus::GetGeographicalLength(const TransportCatalogue& catalogue) const {
+    // Координаты из общего столбца, без обращения к самим остановкам
+    const auto route = catalogue.GetRoute(id_);
+    const auto& coordinates = catalogue.GetStopCoordinates();
     double len = 0;
-    for (size_t i = 0; i < stops_.size() - 1; ++i) {
-        len += ComputeDistance(stops_[i]->coordinates_, stops_[i + 1]->coordinates_);
+    for (size_t i = 0; i + 1 < route.size(); ++i) {
+        len += ComputeDistance(coordinates[route[i]], coordinates[route[i + 1]]);
     }
     return len;
 }
 
-size_t Bus::GetUniqueCount() const {
-    std::unordered_set<std::string_view> uniq;
-    for (const Stop* stop : stops_) {
-        uniq.insert(stop->name_);
-    }
-    return uniq.size();
+size_t Bus::GetUniqueCount(const TransportCatalogue& catalogue) const {
+    // Обратный путь не добавляет новых остановок
+    const RouteView route = catalogue.GetForwardRoute(id_);
+    std::vector<StopId> uniq(route.begin(), route.end());
+    std::sort(uniq.begin(), uniq.end());
+    return std::unique(uniq.begin(), uniq.end()) - uniq.begin();
 }
 
 bool Bus::is_round() const {
@@ -4,6 +4,8 @@
 #include "geo.h"
 #include <vector>
 #include <string_view>
+#include <cstdint>
+#include <iterator>
 
 namespace transport {
 
@@ -13,10 +15,70 @@ enum class Type {
     NONRING
 };
 
+// Номера остановок и автобусов в столбцах справочника, по порядку добавления
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Ручка остановки: имя в пуле имён справочника и номер в его столбцах,
+// координаты читаются через TransportCatalogue::GetStopCoordinates
 struct Stop {
-    Stop(std::string name, geo::Coordinates(coordinates));
-    std::string name_;
-    geo::Coordinates coordinates_;
+    explicit Stop(std::string_view name);
+    std::string_view name_;
+    // Задаётся при добавлении в справочник
+    StopId id_ = 0;
+};
+
+// Полный проход маршрута без хранения обратной половины: для некольцевого
+// маршрута A B C выдаёт A B C B A, для кольцевого — сохранённые остановки как есть.
+// Ссылается на чужой массив и не переживает его
+template <typename T>
+class RouteTraversal {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = T;
+
+        Iterator(const RouteTraversal* route, size_t index) : route_(route), index_(index) {}
+
+        T operator*() const { return (*route_)[index_]; }
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++index_;
+            return old;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const RouteTraversal* route_;
+        size_t index_;
+    };
+
+    RouteTraversal(const T* data, size_t size, bool roundtrip)
+        : data_(data), stored_(size), size_(roundtrip || size == 0 ? size : size * 2 - 1) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T operator[](size_t index) const {
+        return data_[index < stored_ ? index : size_ - 1 - index];
+    }
+    T front() const { return data_[0]; }
+    T back() const { return (*this)[size_ - 1]; }
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size_); }
+
+private:
+    const T* data_;
+    size_t stored_;
+    size_t size_;
 };
 
 struct BusInfo {
@@ -30,26 +92,28 @@ struct BusInfo {
 
 class TransportCatalogue;
 
+// Ручка автобуса: остановки маршрута хранятся только в справочнике,
+// см. TransportCatalogue::GetRoute и GetForwardRoute
 class Bus {
 public:
     friend class TransportCatalogue;
 
-    Bus(std::string name, std::vector<const Stop*> stops, Type type);
+    Bus(std::string name, Type type);
 
     BusInfo GetInfo(const TransportCatalogue& catalogue) const;
-    const std::vector<const Stop*>& GetStops() const;
-    std::string GetName()   const;
+    const std::string& GetName()   const;
+    BusId GetId() const;
     bool is_round() const;
 
 private:
-    size_t GetCountOfStops()  const;
-    double GetGeographicalLength() const;
+    size_t GetCountOfStops(const TransportCatalogue& catalogue) const;
+    double GetGeographicalLength(const TransportCatalogue& catalogue) const;
     double GetRealLength(const TransportCatalogue& catalogue) const;
-    size_t GetUniqueCount() const;
+    size_t GetUniqueCount(const TransportCatalogue& catalogue) const;
 
     std::string name_;
-    std::vector<const Stop*> stops_;
     Type type_;
+    BusId id_ = 0;
 };
 
 struct BusComparator {
@@ -1,4 +1,5 @@
 #include "json.h"
+#include "output_buffer.h"
 
 #include <iterator>
 
@@ -245,38 +246,21 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
-                break;
-            case '\t':
-                out << "\\t"sv;
-                break;
-            case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
-                break;
-        }
-    }
-    out.put('"');
-}
-
 template <>
 void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
     PrintString(value, ctx.out);
 }
 
+template <>
+void PrintValue<int>(const int& value, const PrintContext& ctx) {
+    output::WriteNumber(ctx.out, value);
+}
+
+template <>
+void PrintValue<double>(const double& value, const PrintContext& ctx) {
+    output::WriteNumber(ctx.out, value);
+}
+
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
     ctx.out << "null"sv;
@@ -351,4 +335,43 @@ void Print(const Document& doc, std::ostream& output) {
     PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
+void Print(const Node& node, std::ostream& output, int indent) {
+    PrintNode(node, PrintContext{output, 4, indent});
+}
+
+void PrintString(std::string_view value, std::ostream& out) {
+    out.put('"');
+    // Участки без спецсимволов выводятся целиком, а не по символу
+    size_t plain_start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        std::string_view escaped;
+        switch (c) {
+            case '\r':
+                escaped = "\\r"sv;
+                break;
+            case '\n':
+                escaped = "\\n"sv;
+                break;
+            case '\t':
+                escaped = "\\t"sv;
+                break;
+            case '"':
+                // Символы " и \ выводятся как \" или \\, соответственно
+                escaped = "\\\""sv;
+                break;
+            case '\\':
+                escaped = "\\\\"sv;
+                break;
+            default:
+                continue;
+        }
+        out.write(value.data() + plain_start, i - plain_start);
+        out << escaped;
+        plain_start = i + 1;
+    }
+    out.write(value.data() + plain_start, value.size() - plain_start);
+    out.put('"');
+}
+
 }  // namespace json
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -70,7 +71,7 @@ public:
     bool IsArray() const {
         return std::holds_alternative<Array>(*this);
     }
-    const Array& AsArray() const {
+    const Array& AsArray() const& {
         using namespace std::literals;
         if (!IsArray()) {
             throw std::logic_error("Not an array"s);
@@ -78,11 +79,20 @@ public:
 
         return std::get<Array>(*this);
     }
+    // У временного узла значение забирается без копирования
+    Array AsArray() && {
+        using namespace std::literals;
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+
+        return std::get<Array>(std::move(*this));
+    }
 
     bool IsString() const {
         return std::holds_alternative<std::string>(*this);
     }
-    const std::string& AsString() const {
+    const std::string& AsString() const& {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
@@ -90,11 +100,19 @@ public:
 
         return std::get<std::string>(*this);
     }
+    std::string AsString() && {
+        using namespace std::literals;
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+
+        return std::get<std::string>(std::move(*this));
+    }
 
     bool IsDict() const {
         return std::holds_alternative<Dict>(*this);
     }
-    const Dict& AsDict() const {
+    const Dict& AsDict() const& {
         using namespace std::literals;
         if (!IsDict()) {
             throw std::logic_error("Not a dict"s);
@@ -102,6 +120,14 @@ public:
 
         return std::get<Dict>(*this);
     }
+    Dict AsDict() && {
+        using namespace std::literals;
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+
+        return std::get<Dict>(std::move(*this));
+    }
 
     bool operator==(const Node& rhs) const {
         return GetValue() == rhs.GetValue();
@@ -141,5 +167,9 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
 Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
+// Узел, вложенный в контейнер с отступом indent, — для потоковой записи ответа
+void Print(const Node& node, std::ostream& output, int indent);
+// Строка в кавычках с экранированием, как её печатает Print
+void PrintString(std::string_view value, std::ostream& out);
 
 }  // namespace json
@@ -3,17 +3,18 @@
 namespace json {
 
 Builder::KeyContext Builder::Key(std::string key) {
-    if (nodes_stack_.empty() || !Top()->IsDict()) {
+    if (nodes_stack_.empty() || key_pending_ || !Top()->IsDict()) {
         throw std::logic_error("Key can only be set in a dictionary");
     }
     auto& dict = const_cast<Dict&>(Top()->AsDict());
-    dict[key] = Node(key);  // Временное значение
-    Push(&dict[key]);
+    // Слот под значение создаётся сразу, Value и Start* записывают прямо в него
+    Push(&dict[std::move(key)]);
+    key_pending_ = true;
     return Builder::KeyContext(*this);
 }
 
 Builder& Builder::EndDict() {
-    if (nodes_stack_.empty() || !Top()->IsDict()) {
+    if (nodes_stack_.empty() || key_pending_ || !Top()->IsDict()) {
         throw std::logic_error("EndDict can only be called on a dictionary");
     }
     Pop();
@@ -21,7 +22,7 @@ Builder& Builder::EndDict() {
 }
 
 Builder& Builder::EndArray() {
-    if (nodes_stack_.empty() || !Top()->IsArray()) {
+    if (nodes_stack_.empty() || key_pending_ || !Top()->IsArray()) {
         throw std::logic_error("EndArray can only be called on an array");
     }
     Pop();
@@ -29,47 +30,39 @@ Builder& Builder::EndArray() {
 }
 
 Builder::DictItemContext Builder::StartDict() {
-    return StartContainer<Dict>();
+    return StartContainer<Dict>(0);
 }
 
-Builder::ArrayItemContext Builder::StartArray() {
-    return StartContainer<Array>();
+Builder::ArrayItemContext Builder::StartArray(size_t capacity) {
+    return StartContainer<Array>(capacity);
 }
 
 template <typename Container>
-auto Builder::StartContainer() -> typename std::conditional<
+auto Builder::StartContainer(size_t capacity) -> typename std::conditional<
     std::is_same<Container, Dict>::value,
     Builder::DictItemContext,
     Builder::ArrayItemContext
 >::type
 {
+    Container container;
+    if constexpr (std::is_same<Container, Array>::value) {
+        container.reserve(capacity);
+    }
+
     if (nodes_stack_.empty() && root_.IsNull()) {
-        root_ = Container{};
+        root_ = std::move(container);
         Push(&root_);
-        return typename std::conditional<
-            std::is_same<Container, Dict>::value,
-            Builder::DictItemContext,
-            Builder::ArrayItemContext
-        >::type(*this);
     }
-
-    if (!nodes_stack_.empty() && Top()->IsArray()) {
+    else if (key_pending_) {
+        // Слот ключа уже на вершине стека и становится самим контейнером
+        *Top() = std::move(container);
+        key_pending_ = false;
+    }
+    else if (!nodes_stack_.empty() && Top()->IsArray()) {
         auto& array = const_cast<Array&>(Top()->AsArray());
-        array.emplace_back(Container{});
+        array.emplace_back(std::move(container));
         Push(&array.back());
     }
-    else if (!nodes_stack_.empty() && Top()->IsString()) {
-        auto key = Top()->AsString();
-        Pop();
-        
-        if (nodes_stack_.empty() || !Top()->IsDict()) {
-            throw std::logic_error("Key must be followed by a value in a dictionary");
-        }
-        
-        auto& dict = const_cast<Dict&>(Top()->AsDict());
-        dict[key] = Container{};
-        Push(&dict[key]);
-    }
     else {
         throw std::logic_error("StartContainer can only be called in an array, after a key, or at the root level");
     }
@@ -81,8 +74,8 @@ auto Builder::StartContainer() -> typename std::conditional<
     >::type(*this);
 }
 
-template Builder::DictItemContext Builder::StartContainer<Dict>();
-template Builder::ArrayItemContext Builder::StartContainer<Array>();
+template Builder::DictItemContext Builder::StartContainer<Dict>(size_t);
+template Builder::ArrayItemContext Builder::StartContainer<Array>(size_t);
 
 Builder& Builder::Value(Node::Value value) {
     if (nodes_stack_.empty()) {
@@ -93,18 +86,14 @@ Builder& Builder::Value(Node::Value value) {
         return *this;
     }
 
-    if (Top()->IsArray()) {
-        auto& array = const_cast<Array&>(Top()->AsArray());
-        array.emplace_back(Node(std::move(value)));
-    } 
-    else if (Top()->IsString()) {
-        auto key = Top()->AsString();
+    if (key_pending_) {
+        *Top() = Node(std::move(value));
+        key_pending_ = false;
         Pop();
-        if (nodes_stack_.empty() || !Top()->IsDict()) {
-            throw std::logic_error("Key must be followed by a value in a dictionary");
-        }
-        auto& dict = const_cast<Dict&>(Top()->AsDict());
-        dict[key] = Node(std::move(value));
+    }
+    else if (Top()->IsArray()) {
+        auto& array = const_cast<Array&>(Top()->AsArray());
+        array.emplace_back(std::move(value));
     }
     else {
         throw std::logic_error("Value can only be set in an array, after a key, or at the root level");
@@ -123,15 +112,15 @@ Node Builder::Build() {
 }
 
 Node* Builder::Top() {
-    return nodes_stack_.top();
+    return nodes_stack_.back();
 }
 
 void Builder::Pop() {
-    nodes_stack_.pop();
+    nodes_stack_.pop_back();
 }
 
 void Builder::Push(Node* node) {
-    nodes_stack_.push(node);
+    nodes_stack_.push_back(node);
 }
 
 // Реализации методов контекстных классов
@@ -152,8 +141,8 @@ Builder::DictItemContext Builder::KeyContext::StartDict() {
     return builder_.StartDict();
 }
 
-Builder::ArrayItemContext Builder::KeyContext::StartArray() {
-    return builder_.StartArray();
+Builder::ArrayItemContext Builder::KeyContext::StartArray(size_t capacity) {
+    return builder_.StartArray(capacity);
 }
 
 Builder::ArrayItemContext Builder::ArrayItemContext::Value(Node::Value value) {
@@ -165,8 +154,8 @@ Builder::DictItemContext Builder::ArrayItemContext::StartDict() {
     return builder_.StartDict();
 }
 
-Builder::ArrayItemContext Builder::ArrayItemContext::StartArray() {
-    return builder_.StartArray();
+Builder::ArrayItemContext Builder::ArrayItemContext::StartArray(size_t capacity) {
+    return builder_.StartArray(capacity);
 }
 
 Builder& Builder::ArrayItemContext::EndArray() {
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "json.h"
-#include <stack>
+#include <vector>
 #include <string>
 #include <stdexcept>
 
@@ -22,13 +22,16 @@ public:
     Builder& EndDict();
     Builder& EndArray();
     DictItemContext StartDict();
-    ArrayItemContext StartArray();
+    // capacity — ожидаемое число элементов, память под них выделяется сразу
+    ArrayItemContext StartArray(size_t capacity = 0);
     Builder& Value(Node::Value value);
     Node Build();    
 
 private:
     Node root_;
-    std::stack<Node*> nodes_stack_; 
+    std::vector<Node*> nodes_stack_; 
+    // На вершине стека — значение только что добавленного ключа, ещё не заданное
+    bool key_pending_ = false;
 
     // Базовый класс контекста со всеми методами Builder
     class BaseContext {
@@ -40,7 +43,7 @@ private:
         Builder& EndDict();
         Builder& EndArray();
         DictItemContext StartDict();
-        ArrayItemContext StartArray();
+        ArrayItemContext StartArray(size_t capacity = 0);
         Builder& Value(Node::Value value);
         Node Build();
 
@@ -60,7 +63,7 @@ private:
         Builder& Value(Node::Value) = delete;
         Builder& EndArray() = delete;
         DictItemContext StartDict() = delete;
-        ArrayItemContext StartArray() = delete;
+        ArrayItemContext StartArray(size_t = 0) = delete;
     };
 
     // Контекст для работы с ключами
@@ -70,7 +73,7 @@ private:
 
         DictItemContext Value(Node::Value value);
         DictItemContext StartDict();
-        ArrayItemContext StartArray();
+        ArrayItemContext StartArray(size_t capacity = 0);
 
         // Запрещаем недопустимые методы
         Builder& EndDict() = delete;
@@ -85,7 +88,7 @@ private:
 
         ArrayItemContext Value(Node::Value value);
         DictItemContext StartDict();
-        ArrayItemContext StartArray();
+        ArrayItemContext StartArray(size_t capacity = 0);
         Builder& EndArray();
 
         // Запрещаем недопустимые методы
@@ -100,7 +103,7 @@ private:
 
     // Шаблонный метод для создания контейнеров
     template <typename Container>
-    auto StartContainer() -> typename std::conditional<
+    auto StartContainer(size_t capacity) -> typename std::conditional<
         std::is_same<Container, Dict>::value,
         DictItemContext,
         ArrayItemContext
@@ -1,80 +1,156 @@
 #include "json_reader.h"
+#include "json_writer.h"
+#include "stats.h"
 #include "transport_router.h" 
-#include <sstream> 
 
 using namespace transport;
 using namespace json;
 using namespace json_reader;
 using namespace std::literals;
 
-json::Dict JsonReader::CreateBusInfoDict(const Request& req) const {
-    using namespace json;
-    
+namespace {
+
+// Имя остановки лежит в пуле справочника: потоковый Writer пишет его без копии,
+// а Builder хранит строку в Node
+std::string_view NameValue(const json::Writer&, std::string_view name) {
+    return name;
+}
+
+std::string NameValue(const json::Builder&, std::string_view name) {
+    return std::string(name);
+}
+
+}
+
+template <typename Writer>
+void JsonReader::WriteBusInfo(Writer& writer, const Request& req) const {
     const Bus* bus = catalogue_.GetBus(req.name_);
     
-    Builder builder;
-    builder.StartDict()
-        .Key("request_id").Value(req.id_);
-    
+    writer.StartDict();
     if (bus != nullptr) {
         BusInfo info = bus->GetInfo(catalogue_);
-        builder.Key("curvature").Value(info.curvature_)
-               .Key("route_length").Value(info.length_)
-               .Key("stop_count").Value(static_cast<int>(info.total_stops_))
-               .Key("unique_stop_count").Value(static_cast<int>(info.unique_));
+        writer.Key("curvature").Value(info.curvature_)
+              .Key("request_id").Value(req.id_)
+              .Key("route_length").Value(info.length_)
+              .Key("stop_count").Value(static_cast<int>(info.total_stops_))
+              .Key("unique_stop_count").Value(static_cast<int>(info.unique_));
     } else {
-        builder.Key("error_message").Value("not found");
+        writer.Key("error_message").Value("not found")
+              .Key("request_id").Value(req.id_);
     }
-    
-    builder.EndDict();
-    return builder.Build().AsDict();
+    writer.EndDict();
 }
 
-json::Dict JsonReader::CreateStopInfoDict(const Request& req) const {
-    using namespace json;
-    
+template <typename Writer>
+void JsonReader::WriteStopInfo(Writer& writer, const Request& req) const {
     const Stop* stop = catalogue_.GetStop(req.name_);
     
-    Builder builder;
-    builder.StartDict()
-        .Key("request_id").Value(req.id_);
-    
+    writer.StartDict();
     if (stop != nullptr) {
         const auto& buses = catalogue_.GetBusesByStop(stop);
-        builder.Key("buses");
-        
-        if (buses.empty()) {
-            builder.StartArray().EndArray();
+        writer.Key("buses");
+        writer.StartArray(buses.size());
+        for (const Bus* bus : buses) {
+            writer.Value(bus->GetName());
+        }
+        writer.EndArray();
+    } else {
+        writer.Key("error_message").Value("not found");
+    }
+    writer.Key("request_id").Value(req.id_);
+    writer.EndDict();
+}
+
+template <typename Writer>
+void JsonReader::WriteMap(Writer& writer, const Request& req) const {
+    writer.StartDict();
+    if ((req.tile_ && !req.tile_->IsValid()) || (req.viewport_ && !req.viewport_->IsValid())) {
+        writer.Key("error_message").Value("not found");
+    } else if (req.viewport_) {
+        std::string svg = RenderViewport(*req.viewport_, req.zoom_);
+        if (req.encoding_) {
+            writer.Key("encoding").Value(std::string(compression::ToString(*req.encoding_)))
+                  .Key("map").Value(compression::EncodeBase64(compression::Compress(svg, *req.encoding_)));
         } else {
-            builder.StartArray();
-            for (const Bus* bus : buses) {
-                builder.Value(std::string(bus->GetName()));
-            }
-            builder.EndArray();
+            writer.Key("map").Value(std::move(svg));
         }
     } else {
-        builder.Key("error_message").Value("not found");
+        const auto map = req.tile_ ? GetRenderedTile(*req.tile_, req.encoding_) : GetRenderedMap(req.encoding_);
+        if (req.encoding_) {
+            writer.Key("encoding").Value(std::string(compression::ToString(*req.encoding_)));
+        }
+        writer.Key("map").Value(*map);
     }
-    
-    builder.EndDict();
-    return builder.Build().AsDict();
+    writer.Key("request_id").Value(req.id_);
+    writer.EndDict();
 }
 
+std::shared_ptr<const std::string> JsonReader::SelectEncoding(RenderedSvg& rendered,
+                                                              std::optional<compression::Encoding> encoding) {
+    if (!encoding) {
+        return rendered.svg;
+    }
+    auto& encoded = rendered.encoded[static_cast<size_t>(*encoding)];
+    if (!encoded) {
+        encoded = std::make_shared<const std::string>(
+            compression::EncodeBase64(compression::Compress(*rendered.svg, *encoding)));
+    }
+    return encoded;
+}
 
-json::Dict JsonReader::CreateMapDict(const Request& req) const {
-    using namespace json;
-    
-    Builder builder;
-    builder.StartDict()
-        .Key("request_id").Value(req.id_)
-        .Key("map").Value(RenderMap())
-        .EndDict();
-    
-    return builder.Build().AsDict();
+const map_renderer::MapRenderer& JsonReader::GetCachedRenderer() const {
+    const size_t catalogue_version = catalogue_.GetVersion();
+    if (!rendered_map_.renderer
+        || rendered_map_.catalogue_version != catalogue_version
+        || rendered_map_.settings_version != render_settings_version_) {
+        rendered_map_ = RenderedMap{};
+        rendered_map_.renderer = std::make_shared<const map_renderer::MapRenderer>(*this, catalogue_);
+        rendered_map_.catalogue_version = catalogue_version;
+        rendered_map_.settings_version = render_settings_version_;
+    }
+    return *rendered_map_.renderer;
+}
+
+std::shared_ptr<const std::string> JsonReader::GetRenderedMap(std::optional<compression::Encoding> encoding) const {
+    std::lock_guard lock(map_mutex_);
+    const auto& renderer = GetCachedRenderer();
+    if (!rendered_map_.map.svg) {
+        stats::ScopedTimer timer("map.render");
+        output::StringStream svg_stream;
+        renderer.RenderMap(svg_stream, map_fragments_, render_settings_version_);
+        rendered_map_.map.svg = std::make_shared<const std::string>(svg_stream.Release());
+    }
+    return SelectEncoding(rendered_map_.map, encoding);
+}
+
+std::shared_ptr<const std::string> JsonReader::GetRenderedTile(const map_renderer::Tile& tile,
+                                                               std::optional<compression::Encoding> encoding) const {
+    std::lock_guard lock(map_mutex_);
+    const auto& renderer = GetCachedRenderer();
+    auto& recent = rendered_map_.recent_tiles;
+    if (auto it = rendered_map_.tiles.find(tile); it != rendered_map_.tiles.end()) {
+        recent.splice(recent.begin(), recent, it->second.recent);
+        return SelectEncoding(it->second.rendered, encoding);
+    }
+
+    output::StringStream svg_stream;
+    renderer.RenderViewport(svg_stream, tile.GetViewport(map_description_.width_, map_description_.height_), tile.zoom);
+    if (rendered_map_.tiles.size() == MAX_CACHED_TILES) {
+        rendered_map_.tiles.erase(recent.back());
+        recent.pop_back();
+    }
+    recent.push_front(tile);
+    CachedTile& cached = rendered_map_.tiles[tile];
+    cached.rendered.svg = std::make_shared<const std::string>(svg_stream.Release());
+    cached.recent = recent.begin();
+    return SelectEncoding(cached.rendered, encoding);
 }
 
-void JsonReader::LoadMap(const std::string& map_str) {
-    map_str_ = map_str;
+std::string JsonReader::RenderViewport(const map_renderer::Viewport& viewport, int zoom) const {
+    std::lock_guard lock(map_mutex_);
+    output::StringStream svg_stream;
+    GetCachedRenderer().RenderViewport(svg_stream, viewport, zoom);
+    return svg_stream.Release();
 }
 
 void JsonReader::ProcessStop(const json::Dict& stop_map) {
@@ -83,12 +159,12 @@ void JsonReader::ProcessStop(const json::Dict& stop_map) {
         .lat = stop_map.at("latitude").AsDouble(),
         .lng = stop_map.at("longitude").AsDouble()
     };
-    catalogue_.AddStop(Stop(std::move(name), coordinates));
+    catalogue_.AddStop(std::move(name), coordinates);
 }
 
 void JsonReader::ProcessStopDistances(const json::Dict& stop_map) {
     std::string_view main_stop = stop_map.at("name").AsString();
-    Dict distances = stop_map.at("road_distances").AsDict();
+    const Dict& distances = stop_map.at("road_distances").AsDict();
     for (const auto& [stop, distance] : distances) {
         catalogue_.SetStopDistance(main_stop, stop, distance.AsInt());
     }
@@ -96,66 +172,159 @@ void JsonReader::ProcessStopDistances(const json::Dict& stop_map) {
 
 void JsonReader::ProcessBus(const json::Dict& bus_map) {
     std::string name = bus_map.at("name").AsString();
+    const Array& node_stops = bus_map.at("stops").AsArray();
     std::vector<const Stop*> stop_ptrs;
-    Array node_stops = bus_map.at("stops").AsArray();
+    stop_ptrs.reserve(node_stops.size());
     
     for (const Node& node : node_stops) {
         const Stop* stop_ptr = catalogue_.GetStop(node.AsString());
         stop_ptrs.push_back(stop_ptr);
     }
     
+    // Обратный путь некольцевого маршрута не хранится, его даёт TransportCatalogue::GetRoute
     Type type = bus_map.at("is_roundtrip").AsBool() ? Type::RING : Type::NONRING;
     
-    if (type == Type::NONRING && !stop_ptrs.empty()) {
-        for (int i = stop_ptrs.size() - 2; i >= 0; --i) {
-            stop_ptrs.push_back(stop_ptrs[i]);
+    catalogue_.AddBus(std::move(name), stop_ptrs, type);
+
+    if (auto it = bus_map.find("departures"); it != bus_map.end()) {
+        std::vector<double> departures;
+        for (const Node& node : it->second.AsArray()) {
+            departures.push_back(node.AsDouble());
         }
+        catalogue_.SetBusDepartures(&catalogue_.GetAllBuses().back(), std::move(departures));
     }
-    
-    catalogue_.AddBus(Bus(std::move(name), stop_ptrs, type));
 }
 
 void JsonReader::GetDescription(const Array& description) {
-    std::vector<Dict> stops_buffer;
-    std::vector<Dict> bus_buffer;
+    std::vector<const Dict*> stops_buffer;
+    std::vector<const Dict*> bus_buffer;
     
     for (const Node& node : description) {
-        Dict map = node.AsDict();
+        const Dict& map = node.AsDict();
         if (map.at("type").AsString() == "Stop") {
-            stops_buffer.push_back(std::move(map));
+            stops_buffer.push_back(&map);
         } else {
-            bus_buffer.push_back(std::move(map));
+            bus_buffer.push_back(&map);
         }
     }
     
-    for (const Dict& stop_map : stops_buffer) {
-        ProcessStop(stop_map);
+    for (const Dict* stop_map : stops_buffer) {
+        ProcessStop(*stop_map);
     }
     
-    for (const Dict& stop_map : stops_buffer) {
-        ProcessStopDistances(stop_map);
+    for (const Dict* stop_map : stops_buffer) {
+        ProcessStopDistances(*stop_map);
     }
     
-    for (const Dict& bus_map : bus_buffer) {
-        ProcessBus(bus_map);
+    for (const Dict* bus_map : bus_buffer) {
+        ProcessBus(*bus_map);
     }
 }
 
 void JsonReader::GetRequest(const Array& requests) {    
+    requests_.reserve(requests_.size() + requests.size());
     for (const Node& node : requests) {
-        Dict map = node.AsDict();
+        const Dict& map = node.AsDict();
         int id = map.at("id").AsInt();        
         std::string_view type_str = map.at("type").AsString();
         
         if (type_str == "Map"sv) {
             requests_.emplace_back(ObjectType::Map, id);
+            Request& request = requests_.back();
+            if (auto it = map.find("tile"); it != map.end()) {
+                const Dict& tile = it->second.AsDict();
+                request.tile_ = map_renderer::Tile{
+                    tile.at("zoom").AsInt(), tile.at("x").AsInt(), tile.at("y").AsInt()
+                };
+            } else if (auto it = map.find("bbox"); it != map.end()) {
+                const Array& bbox = it->second.AsArray();
+                request.viewport_ = map_renderer::Viewport{
+                    {bbox.at(0).AsDouble(), bbox.at(1).AsDouble()},
+                    {bbox.at(2).AsDouble(), bbox.at(3).AsDouble()}
+                };
+                if (auto zoom_it = map.find("zoom"); zoom_it != map.end()) {
+                    request.zoom_ = map_renderer::Tile::ClampZoom(zoom_it->second.AsInt());
+                }
+            }
+            if (auto it = map.find("encoding"); it != map.end()) {
+                const std::string& encoding = it->second.AsString();
+                if (encoding == "gzip"sv) {
+                    request.encoding_ = compression::Encoding::GZIP;
+                } else if (encoding == "deflate"sv) {
+                    request.encoding_ = compression::Encoding::DEFLATE;
+                }
+            }
         } else if (type_str == "Route"sv) {
+            std::optional<double> departure_time;
+            if (auto it = map.find("departure_time"); it != map.end()) {
+                departure_time = it->second.AsDouble();
+            }
+            // Концы маршрута — имена остановок или точки {latitude, longitude}
+            const Node& from = map.at("from");
+            const Node& to = map.at("to");
             requests_.emplace_back(
                 ObjectType::Route, 
                 id,
+                from.IsString() ? from.AsString() : std::string(),
+                to.IsString() ? to.AsString() : std::string(),
+                departure_time
+            );
+            Request& request = requests_.back();
+            if (from.IsDict()) {
+                request.from_point_ = geo::Coordinates{from.AsDict().at("latitude").AsDouble(), from.AsDict().at("longitude").AsDouble()};
+            }
+            if (to.IsDict()) {
+                request.to_point_ = geo::Coordinates{to.AsDict().at("latitude").AsDouble(), to.AsDict().at("longitude").AsDouble()};
+            }
+            if (auto it = map.find("criteria"); it != map.end()) {
+                const std::string& criteria = it->second.AsString();
+                if (criteria == "fewest_transfers"sv) {
+                    request.criteria_ = RouteCriteria::FewestTransfers;
+                } else if (criteria == "pareto"sv) {
+                    request.criteria_ = RouteCriteria::Pareto;
+                }
+            }
+            if (auto it = map.find("max_transfers"); it != map.end()) {
+                request.max_transfers_ = it->second.AsInt();
+            }
+            if (auto it = map.find("time_slack"); it != map.end()) {
+                request.time_slack_ = it->second.AsDouble();
+            }
+        } else if (type_str == "AlternativeRoutes"sv) {
+            requests_.emplace_back(
+                ObjectType::AlternativeRoutes,
+                id,
                 map.at("from").AsString(),
                 map.at("to").AsString()
             );
+            if (auto it = map.find("count"); it != map.end()) {
+                requests_.back().count_ = it->second.AsInt();
+            }
+        } else if (type_str == "NearestStops"sv || type_str == "StopsInRadius"sv) {
+            const ObjectType type = type_str == "NearestStops"sv ? ObjectType::NearestStops : ObjectType::StopsInRadius;
+            requests_.emplace_back(type, id);
+            Request& request = requests_.back();
+            request.point_ = {map.at("latitude").AsDouble(), map.at("longitude").AsDouble()};
+            if (type == ObjectType::NearestStops) {
+                if (auto it = map.find("count"); it != map.end()) {
+                    request.count_ = it->second.AsInt();
+                }
+            } else {
+                request.radius_ = map.at("radius").AsDouble();
+            }
+        } else if (type_str == "StopSearch"sv) {
+            requests_.emplace_back(id, ObjectType::StopSearch, map.at("query").AsString());
+            Request& request = requests_.back();
+            request.count_ = 10;
+            if (auto it = map.find("count"); it != map.end()) {
+                request.count_ = it->second.AsInt();
+            }
+            if (auto it = map.find("mode"); it != map.end()) {
+                request.fuzzy_ = it->second.AsString() == "fuzzy"sv;
+            }
+            if (auto it = map.find("max_edits"); it != map.end()) {
+                request.max_edits_ = it->second.AsInt();
+            }
         } else {            
             ObjectType type = (type_str == "Stop"sv) ? ObjectType::Stop : ObjectType::Bus;
             std::string name = map.at("name").AsString();
@@ -165,31 +334,77 @@ void JsonReader::GetRequest(const Array& requests) {
 }
 
 void JsonReader::AnswerToRequests() const {
-    using namespace json;
-    
-    Builder builder;
-    auto array_context = builder.StartArray();
-    
+    // Ответы пишутся в поток сразу, без промежуточного дерева Node
+    stats::ScopedTimer timer("json.answer");
+    json::Writer writer(output_);
+    writer.StartArray();
     for (const auto& request : requests_) {
-        switch (request.type_) {
-            case ObjectType::Bus:
-                array_context.Value(CreateBusInfoDict(request));
-                break;
-            case ObjectType::Stop:
-                array_context.Value(CreateStopInfoDict(request));
-                break;
-            case ObjectType::Map:
-                array_context.Value(CreateMapDict(request));
-                break;
-            case ObjectType::Route:
-                array_context.Value(CreateRouteDict(request));
-                break;
+        WriteAnswer(writer, request);
+    }
+    writer.EndArray();
+}
+
+json::Dict JsonReader::AnswerRequest(const Request& request) const {
+    json::Builder builder;
+    WriteAnswer(builder, request);
+    return builder.Build().AsDict();
+}
+
+template <typename Writer>
+void JsonReader::WriteAnswer(Writer& writer, const Request& request) const {
+    switch (request.type_) {
+        case ObjectType::Bus: {
+            stats::ScopedTimer timer("request.Bus");
+            WriteBusInfo(writer, request);
+            break;
+        }
+        case ObjectType::Stop: {
+            stats::ScopedTimer timer("request.Stop");
+            WriteStopInfo(writer, request);
+            break;
+        }
+        case ObjectType::Map: {
+            stats::ScopedTimer timer("request.Map");
+            WriteMap(writer, request);
+            break;
+        }
+        case ObjectType::Route: {
+            stats::ScopedTimer timer("request.Route");
+            WriteRoute(writer, request);
+            break;
+        }
+        case ObjectType::AlternativeRoutes: {
+            stats::ScopedTimer timer("request.AlternativeRoutes");
+            WriteAlternativeRoutes(writer, request);
+            break;
+        }
+        case ObjectType::NearestStops: {
+            stats::ScopedTimer timer("request.NearestStops");
+            WriteNearbyStops(writer, request);
+            break;
+        }
+        case ObjectType::StopsInRadius: {
+            stats::ScopedTimer timer("request.StopsInRadius");
+            WriteNearbyStops(writer, request);
+            break;
+        }
+        case ObjectType::StopSearch: {
+            stats::ScopedTimer timer("request.StopSearch");
+            WriteStopSearch(writer, request);
+            break;
         }
     }
-    
-    array_context.EndArray();
-    
-    json::Print(json::Document(builder.Build()), output_);
+}
+
+std::optional<geo::Coordinates> JsonReader::GetPoint(const std::optional<geo::Coordinates>& point,
+                                                     std::string_view stop_name) const {
+    if (point) {
+        return point;
+    }
+    if (const Stop* stop = catalogue_.GetStop(stop_name)) {
+        return catalogue_.GetStopCoordinates()[stop->id_];
+    }
+    return std::nullopt;
 }
 
 svg::Color JsonReader::ParseColor(const json::Node& color_node) const {
@@ -248,84 +463,291 @@ void JsonReader::GetRenderSettings(const Dict& dict) {
         .underlayer_width_ = underlayer_width,
         .color_palette_ = color_palette
     };
+
+    if (auto it = dict.find("number_format"); it != dict.end()) {
+        const std::string& mode = it->second.AsString();
+        if (mode == "shortest"sv) {
+            result.number_format_.mode = output::NumberMode::SHORTEST;
+        } else if (mode == "fixed"sv) {
+            result.number_format_.mode = output::NumberMode::FIXED;
+        }
+    }
+    if (auto it = dict.find("coordinate_precision"); it != dict.end()) {
+        result.number_format_.precision = std::max(it->second.AsInt(), 0);
+    }
+    if (auto it = dict.find("simplify_tolerance"); it != dict.end()) {
+        result.simplify_tolerance_ = it->second.AsDouble();
+    }
     map_description_ = std::move(result);
+    ++render_settings_version_;
 }
 
 std::string JsonReader::RenderMap() const {
     map_renderer::MapRenderer renderer(*this, catalogue_);
-    svg::Document doc = renderer.RenderMap();
-    std::ostringstream svg_stream;
-    doc.Render(svg_stream);
-    return svg_stream.str();
+    output::StringStream svg_stream;
+    renderer.RenderMap(svg_stream);
+    return svg_stream.Release();
 }
 
 void JsonReader::GetRoutingSettings(const json::Dict& dict) {
     router_settings_.bus_wait_time = dict.at("bus_wait_time").AsInt();
     router_settings_.bus_velocity = dict.at("bus_velocity").AsDouble();
+    if (auto it = dict.find("route_cache_size"); it != dict.end()) {
+        // Отрицательный размер, как и 0, выключает кэш
+        router_settings_.route_cache_size = static_cast<size_t>(std::max(it->second.AsInt(), 0));
+    }
+    if (auto it = dict.find("walking_velocity"); it != dict.end()) {
+        router_settings_.walking_velocity = it->second.AsDouble();
+    }
+    if (auto it = dict.find("max_walking_distance"); it != dict.end()) {
+        router_settings_.max_walking_distance = it->second.AsDouble();
+    }
 }
 
-json::Dict JsonReader::CreateRouteDict(const Request& req) const {
-    using namespace json;
+template <typename Writer>
+void JsonReader::WriteRoute(Writer& writer, const Request& req) const {
     using transport::RouteInfo;
     
-    if (!router_) {
-        return Builder{}
-            .StartDict()
-                .Key("request_id").Value(req.id_)
-                .Key("error_message").Value("not found")
-            .EndDict()
-            .Build().AsDict();
+    // Расписание знает только самый быстрый маршрут между остановками:
+    // departure_time вместе с точками или criteria не поддерживается
+    const bool unsupported = req.departure_time_
+        && (req.from_point_ || req.to_point_ || req.criteria_ != RouteCriteria::Fastest);
+    const Routers routers = GetRouters();
+    if (!routers.router || unsupported) {
+        writer.StartDict()
+              .Key("error_message").Value("not found")
+              .Key("request_id").Value(req.id_)
+              .EndDict();
+        return;
     }
     
-    auto route_info = router_->FindRoute(req.from_, req.to_);
-    
-    Builder builder;
-    builder.StartDict()
-        .Key("request_id").Value(req.id_);
+    if (req.criteria_ == RouteCriteria::Pareto && !req.from_point_ && !req.to_point_) {
+        WriteParetoRoutes(writer, req, *routers.router);
+        return;
+    }
+
+    std::optional<RouteInfo> route_info;
+    if (req.from_point_ || req.to_point_) {
+        // Между точками ищется только самый быстрый маршрут
+        const auto from = GetPoint(req.from_point_, req.from_);
+        const auto to = GetPoint(req.to_point_, req.to_);
+        if (from && to) {
+            route_info = routers.router->FindRoute(*from, *to, *stop_index_);
+        }
+    } else if (req.departure_time_) {
+        route_info = routers.timetable->FindRoute(req.from_, req.to_, *req.departure_time_);
+    } else if (req.criteria_ == RouteCriteria::FewestTransfers) {
+        route_info = routers.router->FindFewestTransfersRoute(req.from_, req.to_, req.max_transfers_, req.time_slack_);
+    } else {
+        route_info = routers.router->FindRoute(req.from_, req.to_);
+    }
     
+    writer.StartDict();
     if (route_info) {
-        builder.Key("total_time").Value(route_info->total_time)
-               .Key("items").StartArray();
-        
-        for (const auto& item : route_info->items) {
-            if (std::holds_alternative<RouteInfo::WaitItem>(item)) {
-                const auto& wait_item = std::get<RouteInfo::WaitItem>(item);
-                builder.StartDict()
-                    .Key("type").Value("Wait")
-                    .Key("stop_name").Value(wait_item.stop_name)
-                    .Key("time").Value(wait_item.time)
-                    .EndDict();
-            } else {
-                const auto& bus_item = std::get<RouteInfo::BusItem>(item);
-                builder.StartDict()
-                    .Key("type").Value("Bus")
-                    .Key("bus").Value(bus_item.bus_name)
-                    .Key("span_count").Value(bus_item.span_count)
-                    .Key("time").Value(bus_item.time)
-                    .EndDict();
-            }
+        WriteRouteItems(writer, *route_info);
+        writer.Key("request_id").Value(req.id_)
+              .Key("total_time").Value(route_info->total_time);
+    } else {
+        stats::Count("route.not_found");
+        writer.Key("error_message").Value("not found")
+              .Key("request_id").Value(req.id_);
+    }
+    writer.EndDict();
+}
+
+template <typename Writer>
+void JsonReader::WriteParetoRoutes(Writer& writer, const Request& req, const transport::TransportRouter& router) const {
+    auto routes = router.FindParetoRoutes(req.from_, req.to_, req.max_transfers_);
+
+    writer.StartDict();
+    if (routes.empty()) {
+        writer.Key("error_message").Value("not found");
+    }
+    writer.Key("request_id").Value(req.id_);
+    if (!routes.empty()) {
+        writer.Key("routes").StartArray(routes.size());
+        for (const auto& route_info : routes) {
+            writer.StartDict();
+            WriteRouteItems(writer, route_info);
+            writer.Key("total_time").Value(route_info.total_time)
+                  .Key("transfers").Value(route_info.GetTransferCount());
+            writer.EndDict();
         }
-        
-        builder.EndArray();
+        writer.EndArray();
+    }
+    writer.EndDict();
+}
+
+template <typename Writer>
+void JsonReader::WriteNearbyStops(Writer& writer, const Request& req) const {
+    std::vector<transport::NearbyStop> stops;
+    if (req.type_ == ObjectType::NearestStops) {
+        stops = stop_index_->NearestStops(req.point_, std::max(req.count_, 0));
     } else {
-        std::cerr << "Something wrong here" << std::endl;
-        builder.Key("error_message").Value("not found");
+        stops = stop_index_->StopsInRadius(req.point_, req.radius_);
     }
-    
-    builder.EndDict();
-    return builder.Build().AsDict();
+
+    writer.StartDict()
+          .Key("request_id").Value(req.id_)
+          .Key("stops").StartArray(stops.size());
+    for (const auto& [stop, distance] : stops) {
+        writer.StartDict()
+              .Key("distance").Value(distance)
+              .Key("name").Value(NameValue(writer, stop->name_))
+              .EndDict();
+    }
+    writer.EndArray();
+    writer.EndDict();
+}
+
+template <typename Writer>
+void JsonReader::WriteStopSearch(Writer& writer, const Request& req) const {
+    const size_t limit = std::max(req.count_, 0);
+    writer.StartDict()
+          .Key("request_id").Value(req.id_);
+    if (req.fuzzy_) {
+        const auto matches = stop_names_->FindSimilar(req.name_, req.max_edits_, limit);
+        writer.Key("stops").StartArray(matches.size());
+        for (const auto& [stop, edits] : matches) {
+            writer.StartDict()
+                  .Key("edits").Value(edits)
+                  .Key("name").Value(NameValue(writer, stop->name_))
+                  .EndDict();
+        }
+    } else {
+        const auto stops = stop_names_->FindByPrefix(req.name_, limit);
+        writer.Key("stops").StartArray(stops.size());
+        for (const Stop* stop : stops) {
+            writer.StartDict()
+                  .Key("name").Value(NameValue(writer, stop->name_))
+                  .EndDict();
+        }
+    }
+    writer.EndArray();
+    writer.EndDict();
+}
+
+template <typename Writer>
+void JsonReader::WriteRouteItems(Writer& writer, const transport::RouteInfo& route_info) const {
+    using transport::RouteInfo;
+
+    writer.Key("items").StartArray(route_info.items.size());
+    for (const auto& item : route_info.items) {
+        if (const auto* wait_item = std::get_if<RouteInfo::WaitItem>(&item)) {
+            writer.StartDict()
+                  .Key("stop_name").Value(NameValue(writer, wait_item->stop->name_))
+                  .Key("time").Value(wait_item->time)
+                  .Key("type").Value("Wait")
+                  .EndDict();
+        } else if (const auto* bus_item = std::get_if<RouteInfo::BusItem>(&item)) {
+            writer.StartDict()
+                  .Key("bus").Value(bus_item->bus->GetName())
+                  .Key("span_count").Value(bus_item->span_count)
+                  .Key("time").Value(bus_item->time)
+                  .Key("type").Value("Bus")
+                  .EndDict();
+        } else {
+            // Концы-точки в ответе не называются: from и to есть только у остановок
+            const auto& walk_item = std::get<RouteInfo::WalkItem>(item);
+            writer.StartDict();
+            if (walk_item.from) {
+                writer.Key("from").Value(NameValue(writer, walk_item.from->name_));
+            }
+            writer.Key("time").Value(walk_item.time);
+            if (walk_item.to) {
+                writer.Key("to").Value(NameValue(writer, walk_item.to->name_));
+            }
+            writer.Key("type").Value("Walk");
+            writer.EndDict();
+        }
+    }
+    writer.EndArray();
+}
+
+template <typename Writer>
+void JsonReader::WriteAlternativeRoutes(Writer& writer, const Request& req) const {
+    std::vector<transport::RouteInfo> routes;
+    if (const auto router = GetRouters().router) {
+        routes = router->FindAlternativeRoutes(req.from_, req.to_, std::max(req.count_, 0));
+    }
+
+    writer.StartDict();
+    if (routes.empty()) {
+        writer.Key("error_message").Value("not found");
+    }
+    writer.Key("request_id").Value(req.id_);
+    if (!routes.empty()) {
+        writer.Key("routes").StartArray(routes.size());
+        for (const auto& route_info : routes) {
+            writer.StartDict();
+            WriteRouteItems(writer, route_info);
+            writer.Key("total_time").Value(route_info.total_time);
+            writer.EndDict();
+        }
+        writer.EndArray();
+    }
+    writer.EndDict();
 }
 
 void JsonReader::Read() {
-    Document doc = Load(input_);
-    Dict map = doc.GetRoot().AsDict();
+    std::optional<Document> doc;
+    {
+        stats::ScopedTimer timer("json.load");
+        doc.emplace(Load(input_));
+    }
+    const Dict& map = doc->GetRoot().AsDict();
 
-    GetDescription(map.at("base_requests").AsArray());
-    GetRenderSettings(map.at("render_settings").AsDict());
-    
-    if (map.count("routing_settings")) {
-        GetRoutingSettings(map.at("routing_settings").AsDict());
-        router_ = std::make_unique<transport::TransportRouter>(catalogue_, router_settings_);
-    }    
-    GetRequest(map.at("stat_requests").AsArray());
+    ReadBase(map);
+    BuildRouters();
+    ReadRequests(map);
+}
+
+void JsonReader::ReadBase(const json::Dict& root) {
+    stats::ScopedTimer timer("catalogue.build");
+    GetDescription(root.at("base_requests").AsArray());
+    stats::SetGauge("catalogue.stops", catalogue_.GetAllStops().size());
+    stats::SetGauge("catalogue.buses", catalogue_.GetAllBuses().size());
+    {
+        // После base_requests набор имён не меняется
+        stats::ScopedTimer freeze_timer("catalogue.freeze_names");
+        catalogue_.FreezeNames();
+    }
+    {
+        stats::ScopedTimer index_timer("stop_index.build");
+        stop_index_ = std::make_unique<transport::StopIndex>(catalogue_);
+    }
+    {
+        stats::ScopedTimer names_timer("stop_search.build");
+        stop_names_ = std::make_unique<transport::StopNameIndex>(catalogue_);
+    }
+    GetRenderSettings(root.at("render_settings").AsDict());
+
+    if (auto it = root.find("routing_settings"); it != root.end()) {
+        GetRoutingSettings(it->second.AsDict());
+        has_routing_settings_ = true;
+    }
+}
+
+void JsonReader::BuildRouters() {
+    GetRouters();
+}
+
+JsonReader::Routers JsonReader::GetRouters() const {
+    if (!has_routing_settings_) {
+        return {};
+    }
+    std::lock_guard lock(routers_mutex_);
+    const size_t catalogue_version = catalogue_.GetVersion();
+    if (!routers_.router || routers_.catalogue_version != catalogue_version) {
+        stats::ScopedTimer timer("routers.build");
+        routers_.router = std::make_shared<const transport::TransportRouter>(catalogue_, router_settings_);
+        routers_.timetable = std::make_shared<const transport::TimetableRouter>(catalogue_, router_settings_);
+        routers_.catalogue_version = catalogue_version;
+    }
+    return routers_;
+}
+
+void JsonReader::ReadRequests(const json::Dict& root) {
+    stats::ScopedTimer timer("requests.parse");
+    GetRequest(root.at("stat_requests").AsArray());
 }
@@ -6,24 +6,61 @@
 #include "map_renderer.h"
 #include "json_builder.h"
 #include "transport_router.h" 
+#include "timetable_router.h"
+#include "compression.h"
+#include "stop_index.h"
+#include "stop_search.h"
+
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 namespace json_reader {
 
 enum class ObjectType
 {
-    Bus, Stop, Map, Route
+    Bus, Stop, Map, Route, AlternativeRoutes, NearestStops, StopsInRadius, StopSearch
+};
+
+enum class RouteCriteria
+{
+    Fastest, FewestTransfers, Pareto
 };
 
 struct Request {
-    Request(int id, ObjectType type, std::string name) : id_(id), type_(type), name_(name) {}
+    Request(int id, ObjectType type, std::string name) : id_(id), type_(type), name_(std::move(name)) {}
     Request(ObjectType type, int id) : id_(id), type_(type) {}
-    Request(ObjectType type, int id, std::string from, std::string to)
-        : id_(id), type_(type), from_(std::move(from)), to_(std::move(to)) {}
+    Request(ObjectType type, int id, std::string from, std::string to, std::optional<double> departure_time = std::nullopt)
+        : id_(id), type_(type), from_(std::move(from)), to_(std::move(to)), departure_time_(departure_time) {}
     int id_;
     ObjectType type_;
     std::string name_;
     std::string from_;  
     std::string to_;
+    // Маршрут по расписанию: только между остановками и без criteria,
+    // иначе ответ not found
+    std::optional<double> departure_time_;
+    int count_ = 1;
+    RouteCriteria criteria_ = RouteCriteria::Fastest;
+    int max_transfers_ = 4;
+    double time_slack_ = 0.1;
+    std::optional<map_renderer::Tile> tile_;
+    std::optional<map_renderer::Viewport> viewport_;
+    int zoom_ = 0;
+    // Карта отдаётся сжатой и закодированной в base64
+    std::optional<compression::Encoding> encoding_;
+    // Маршрут между точками: если задана хотя бы одна, другой конец
+    // из from_ или to_ берётся как координаты остановки
+    std::optional<geo::Coordinates> from_point_;
+    std::optional<geo::Coordinates> to_point_;
+    // Точка и радиус в метрах для поиска остановок поблизости
+    geo::Coordinates point_{};
+    double radius_ = 0;
+    // StopSearch: name_ — запрос, по префиксу или с опечатками
+    bool fuzzy_ = false;
+    int max_edits_ = 1;
 };
 
 class JsonReader {
@@ -32,15 +69,37 @@ public:
         : input_(input), output_(output), catalogue_(catalogue) {}
 
     void Read();
+    // Этапы Read по отдельности: справочник и настройки, роутеры, запросы
+    void ReadBase(const json::Dict& root);
+    void BuildRouters();
+    void ReadRequests(const json::Dict& root);
+
     void AnswerToRequests() const;
+    json::Dict AnswerRequest(const Request& request) const;
+    const std::vector<Request>& GetRequests() const {
+        return requests_;
+    }
     std::string RenderMap() const;
 
+    // Карта рендерится один раз на версию справочника и настроек отрисовки,
+    // результат разделяется между всеми запросами Map. С encoding — сжатая
+    // и закодированная в base64, тоже один раз на версию
+    std::shared_ptr<const std::string> GetRenderedMap(std::optional<compression::Encoding> encoding = std::nullopt) const;
+    // Тайлы кэшируются по (zoom, x, y) вместе с полной картой, не больше
+    // MAX_CACHED_TILES последних использованных. tile должен быть IsValid
+    std::shared_ptr<const std::string> GetRenderedTile(const map_renderer::Tile& tile,
+                                                       std::optional<compression::Encoding> encoding = std::nullopt) const;
+    std::string RenderViewport(const map_renderer::Viewport& viewport, int zoom) const;
+
+    // nullptr без routing_settings. Роутер соответствует текущей версии справочника
+    std::shared_ptr<const transport::TransportRouter> GetRouter() const {
+        return GetRouters().router;
+    }
+
     map_renderer::MapDescription GetMapDescription() const {
         return map_description_;
     }
 
-    void LoadMap(const std::string& map_str);    
-
 private:
     void GetDescription(const json::Array& discription);
     void GetRequest(const json::Array& requests);
@@ -48,11 +107,30 @@ private:
     void ProcessStopDistances(const json::Dict& stop_map);
     void ProcessStop(const json::Dict& stop_map);
 
-    json::Dict CreateBusInfoDict(const Request& req) const;    
-    json::Dict CreateStopInfoDict(const Request& req) const;    
-    json::Dict CreateMapDict(const Request& req) const;
+    // Writer — json::Builder или потоковый json::Writer, поэтому ключи
+    // словарей пишутся в порядке возрастания
+    template <typename Writer>
+    void WriteAnswer(Writer& writer, const Request& request) const;
+    template <typename Writer>
+    void WriteBusInfo(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteStopInfo(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteMap(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteRoute(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteParetoRoutes(Writer& writer, const Request& req, const transport::TransportRouter& router) const;
+    template <typename Writer>
+    void WriteAlternativeRoutes(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteNearbyStops(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteStopSearch(Writer& writer, const Request& req) const;
+    template <typename Writer>
+    void WriteRouteItems(Writer& writer, const transport::RouteInfo& route_info) const;
     svg::Color ParseColor(const json::Node& color_node) const;
-    json::Dict CreateRouteDict(const Request& req) const;
+    std::optional<geo::Coordinates> GetPoint(const std::optional<geo::Coordinates>& point, std::string_view stop_name) const;
 
     void GetRenderSettings(const json::Dict& dict);
     void GetRoutingSettings(const json::Dict& dict);
@@ -64,10 +142,57 @@ private:
     transport::TransportCatalogue& catalogue_;    
 
     map_renderer::MapDescription map_description_;
-    std::string map_str_;
+    size_t render_settings_version_ = 0;
+
+    static constexpr size_t MAX_CACHED_TILES = 256;
+
+    // SVG карты или тайла вместе со своими сжатыми вариантами
+    struct RenderedSvg {
+        std::shared_ptr<const std::string> svg;
+        std::array<std::shared_ptr<const std::string>, compression::ENCODING_COUNT> encoded;
+    };
+
+    struct CachedTile {
+        RenderedSvg rendered;
+        std::list<map_renderer::Tile>::iterator recent;
+    };
+
+    struct RenderedMap {
+        size_t catalogue_version = 0;
+        size_t settings_version = 0;
+        std::shared_ptr<const map_renderer::MapRenderer> renderer;
+        RenderedSvg map;
+        std::map<map_renderer::Tile, CachedTile> tiles;
+        // Тайлы от последнего использованного к самому давнему
+        std::list<map_renderer::Tile> recent_tiles;
+    };
+    // Вызывается под map_mutex_: svg или его вариант в encoding, сжимается при первом запросе
+    static std::shared_ptr<const std::string> SelectEncoding(RenderedSvg& rendered,
+                                                             std::optional<compression::Encoding> encoding);
+    // Вызывается под map_mutex_: сбрасывает кэш при смене версий
+    const map_renderer::MapRenderer& GetCachedRenderer() const;
+    mutable std::mutex map_mutex_;
+    mutable RenderedMap rendered_map_;
+    // Живёт дольше rendered_map_: после изменения справочника перерисовываются
+    // только затронутые маршруты и остановки
+    mutable map_renderer::FragmentCache map_fragments_;
 
     transport::RoutingSettings router_settings_;
-    std::unique_ptr<transport::TransportRouter> router_;
+    bool has_routing_settings_ = false;
+
+    // Роутеры — снимок справочника: перестраиваются при первом запросе после
+    // смены его версии, как кэш карты. Запрос держит свою пару до конца
+    struct Routers {
+        size_t catalogue_version = 0;
+        std::shared_ptr<const transport::TransportRouter> router;
+        std::shared_ptr<const transport::TimetableRouter> timetable;
+    };
+    Routers GetRouters() const;
+    mutable std::mutex routers_mutex_;
+    mutable Routers routers_;
+    // Строится в ReadBase, когда справочник заполнен
+    std::unique_ptr<transport::StopIndex> stop_index_;
+    std::unique_ptr<transport::StopNameIndex> stop_names_;
 };
 
 } // namespace json_reader
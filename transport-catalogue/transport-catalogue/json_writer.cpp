@@ -0,0 +1,126 @@
+#include "json_writer.h"
+#include "output_buffer.h"
+
+#include <stdexcept>
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int INDENT_STEP = 4;
+
+void PrintIndent(std::ostream& out, size_t depth) {
+    for (size_t i = 0; i < depth * INDENT_STEP; ++i) {
+        out.put(' ');
+    }
+}
+
+}
+
+void Writer::BeginItem() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (has_items_.empty()) {
+        return;
+    }
+    if (has_items_.back()) {
+        out_ << ",\n"sv;
+    }
+    has_items_.back() = true;
+    PrintIndent(out_, has_items_.size());
+}
+
+void Writer::EndContainer(char bracket) {
+    if (has_items_.empty() || after_key_) {
+        throw std::logic_error("No container to close");
+    }
+    has_items_.pop_back();
+    out_.put('\n');
+    PrintIndent(out_, has_items_.size());
+    out_.put(bracket);
+}
+
+Writer& Writer::StartDict() {
+    BeginItem();
+    out_ << "{\n"sv;
+    has_items_.push_back(false);
+    return *this;
+}
+
+Writer& Writer::EndDict() {
+    EndContainer('}');
+    return *this;
+}
+
+Writer& Writer::StartArray(size_t) {
+    BeginItem();
+    out_ << "[\n"sv;
+    has_items_.push_back(false);
+    return *this;
+}
+
+Writer& Writer::EndArray() {
+    EndContainer(']');
+    return *this;
+}
+
+Writer& Writer::Key(std::string_view key) {
+    if (has_items_.empty() || after_key_) {
+        throw std::logic_error("Key can only be set in a dictionary");
+    }
+    BeginItem();
+    PrintString(key, out_);
+    out_ << ": "sv;
+    after_key_ = true;
+    return *this;
+}
+
+Writer& Writer::Value(std::nullptr_t) {
+    BeginItem();
+    out_ << "null"sv;
+    return *this;
+}
+
+Writer& Writer::Value(bool value) {
+    BeginItem();
+    out_ << (value ? "true"sv : "false"sv);
+    return *this;
+}
+
+Writer& Writer::Value(int value) {
+    BeginItem();
+    output::WriteNumber(out_, value);
+    return *this;
+}
+
+Writer& Writer::Value(double value) {
+    BeginItem();
+    output::WriteNumber(out_, value);
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    BeginItem();
+    PrintString(value, out_);
+    return *this;
+}
+
+Writer& Writer::Value(const std::string& value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const Node& node) {
+    BeginItem();
+    Print(node, out_, static_cast<int>(has_items_.size()) * INDENT_STEP);
+    return *this;
+}
+
+} // namespace json
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "json.h"
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Пишет JSON прямо в поток, не строя дерево Node. Вывод совпадает с json::Print,
+// поэтому ключи словаря нужно передавать в порядке возрастания, как их хранит Dict.
+class Writer {
+public:
+    explicit Writer(std::ostream& out) : out_(out) {}
+
+    Writer& StartDict();
+    Writer& EndDict();
+    // capacity не используется и нужен для совместимости с Builder
+    Writer& StartArray(size_t capacity = 0);
+    Writer& EndArray();
+    Writer& Key(std::string_view key);
+
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    Writer& Value(const std::string& value);
+    Writer& Value(const char* value);
+    Writer& Value(const Node& node);
+
+private:
+    // Запятая и отступ перед очередным элементом
+    void BeginItem();
+    void EndContainer(char bracket);
+
+    std::ostream& out_;
+    // Для каждого открытого контейнера: записан ли в него хоть один элемент
+    std::vector<bool> has_items_;
+    bool after_key_ = false;
+};
+
+} // namespace json
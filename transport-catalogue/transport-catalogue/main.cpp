@@ -1,28 +1,84 @@
 #include "request_handler.h"
 #include "json_reader.h"
-#include <sstream>
-#include "map_renderer.h"
+#include "stats.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <new>
 
 using namespace json_reader;
 using namespace transport;
 using namespace std;
-using namespace map_renderer;
 
+// Выделения памяти учитываются в stats, когда сбор включён.
+// Выровненные варианты не подменяются: в справочнике они не используются
+void* operator new(size_t size) {
+    stats::RecordAllocation(size);
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    stats::RecordAllocation(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, const nothrow_t&) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, const nothrow_t&) noexcept {
+    free(ptr);
+}
 
 
 int main() {
+    // TC_STATS и TC_TRACE — пути для отчёта и trace-файла; без них сбор выключен
+    const char* stats_path = getenv("TC_STATS");
+    const char* trace_path = getenv("TC_TRACE");
+    if (stats_path || trace_path) {
+        stats::Enable(trace_path != nullptr);
+    }
+
     TransportCatalogue catalogue;
     JsonReader reader(cin, cout, catalogue);
     reader.Read();
-
-    MapRenderer renderer(reader, catalogue);    
-    svg::Document svg_map = renderer.RenderMap();
-    
-    std::ostringstream oss;
-    svg_map.Render(oss);
-    std::string map = oss.str();
-    reader.LoadMap(map);
     reader.AnswerToRequests();
 
+    if (stats_path) {
+        ofstream out(stats_path);
+        stats::WriteReport(out);
+    }
+    if (trace_path) {
+        ofstream out(trace_path);
+        stats::WriteTrace(out);
+    }
+
     return 0;
 }
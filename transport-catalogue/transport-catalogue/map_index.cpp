@@ -0,0 +1,175 @@
+#include "map_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace map_renderer {
+
+Viewport Viewport::Around(svg::Point point) {
+    return {point, point};
+}
+
+Viewport Viewport::Expanded(double margin) const {
+    return {{min.x - margin, min.y - margin}, {max.x + margin, max.y + margin}};
+}
+
+void Viewport::Extend(svg::Point point) {
+    min.x = std::min(min.x, point.x);
+    min.y = std::min(min.y, point.y);
+    max.x = std::max(max.x, point.x);
+    max.y = std::max(max.y, point.y);
+}
+
+bool Viewport::Contains(svg::Point point) const {
+    return min.x <= point.x && point.x <= max.x && min.y <= point.y && point.y <= max.y;
+}
+
+bool Viewport::IsValid() const {
+    return std::isfinite(min.x) && std::isfinite(min.y) && std::isfinite(max.x) && std::isfinite(max.y);
+}
+
+bool Viewport::IntersectsSegment(svg::Point from, svg::Point to) const {
+    // Отсечение Лианга — Барски
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    double t_enter = 0;
+    double t_exit = 1;
+
+    const auto clip = [&t_enter, &t_exit](double p, double q) {
+        if (p == 0) {
+            return q >= 0;
+        }
+        const double t = q / p;
+        if (p < 0) {
+            t_enter = std::max(t_enter, t);
+        } else {
+            t_exit = std::min(t_exit, t);
+        }
+        return t_enter <= t_exit;
+    };
+
+    return clip(-dx, from.x - min.x) && clip(dx, max.x - from.x)
+        && clip(-dy, from.y - min.y) && clip(dy, max.y - from.y);
+}
+
+int Tile::ClampZoom(int zoom) {
+    return std::clamp(zoom, 0, MAX_ZOOM);
+}
+
+bool Tile::IsValid() const {
+    if (zoom < 0 || zoom > MAX_ZOOM) {
+        return false;
+    }
+    const int64_t tiles = int64_t{1} << zoom;
+    return x >= 0 && y >= 0 && x < tiles && y < tiles;
+}
+
+Viewport Tile::GetViewport(double width, double height) const {
+    const double tiles = std::ldexp(1.0, zoom);
+    const double tile_width = width / tiles;
+    const double tile_height = height / tiles;
+    return {{x * tile_width, y * tile_height}, {(x + 1) * tile_width, (y + 1) * tile_height}};
+}
+
+namespace {
+
+double SegmentDistance(svg::Point point, svg::Point from, svg::Point to) {
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    const double length_sq = dx * dx + dy * dy;
+    double t = 0;
+    if (length_sq > 0) {
+        t = std::clamp(((point.x - from.x) * dx + (point.y - from.y) * dy) / length_sq, 0.0, 1.0);
+    }
+    return std::hypot(point.x - (from.x + t * dx), point.y - (from.y + t * dy));
+}
+
+}
+
+std::vector<svg::Point> SimplifyPolyline(const std::vector<svg::Point>& points, double tolerance) {
+    if (points.size() < 3 || tolerance <= 0) {
+        return points;
+    }
+
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = keep.back() = true;
+
+    std::vector<std::pair<size_t, size_t>> ranges{{0, points.size() - 1}};
+    while (!ranges.empty()) {
+        const auto [first, last] = ranges.back();
+        ranges.pop_back();
+
+        double max_distance = 0;
+        size_t farthest = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            const double distance = SegmentDistance(points[i], points[first], points[last]);
+            if (distance > max_distance) {
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+
+        if (max_distance > tolerance) {
+            keep[farthest] = true;
+            ranges.emplace_back(first, farthest);
+            ranges.emplace_back(farthest, last);
+        }
+    }
+
+    std::vector<svg::Point> result;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (keep[i]) {
+            result.push_back(points[i]);
+        }
+    }
+    return result;
+}
+
+SpatialGrid::SpatialGrid(const Viewport& bounds, size_t side)
+    : bounds_(bounds)
+    , side_(std::max<size_t>(side, 1))
+    , cell_width_((bounds.max.x - bounds.min.x) / side_)
+    , cell_height_((bounds.max.y - bounds.min.y) / side_)
+    , cells_(side_ * side_) {
+}
+
+size_t SpatialGrid::CellX(double x) const {
+    // Ограничиваем до приведения: double вне диапазона size_t — UB, NaN уходит в нулевую ячейку
+    if (!(cell_width_ > 0) || !(x > bounds_.min.x)) {
+        return 0;
+    }
+    return static_cast<size_t>(std::min((x - bounds_.min.x) / cell_width_, static_cast<double>(side_ - 1)));
+}
+
+size_t SpatialGrid::CellY(double y) const {
+    if (!(cell_height_ > 0) || !(y > bounds_.min.y)) {
+        return 0;
+    }
+    return static_cast<size_t>(std::min((y - bounds_.min.y) / cell_height_, static_cast<double>(side_ - 1)));
+}
+
+void SpatialGrid::Insert(const Viewport& box, uint32_t id) {
+    for (size_t y = CellY(box.min.y), y_end = CellY(box.max.y); y <= y_end; ++y) {
+        for (size_t x = CellX(box.min.x), x_end = CellX(box.max.x); x <= x_end; ++x) {
+            auto& cell = cells_[y * side_ + x];
+            if (cell.empty() || cell.back() != id) {
+                cell.push_back(id);
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> SpatialGrid::Query(const Viewport& box) const {
+    std::vector<uint32_t> result;
+    for (size_t y = CellY(box.min.y), y_end = CellY(box.max.y); y <= y_end; ++y) {
+        for (size_t x = CellX(box.min.x), x_end = CellX(box.max.x); x <= x_end; ++x) {
+            const auto& cell = cells_[y * side_ + x];
+            result.insert(result.end(), cell.begin(), cell.end());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+} // namespace map_renderer
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "svg.h"
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace map_renderer {
+
+// Прямоугольник в координатах карты (после проекции)
+struct Viewport {
+    svg::Point min;
+    svg::Point max;
+
+    static Viewport Around(svg::Point point);
+
+    Viewport Expanded(double margin) const;
+    void Extend(svg::Point point);
+
+    bool Contains(svg::Point point) const;
+    bool IntersectsSegment(svg::Point from, svg::Point to) const;
+    // Все координаты конечны: NaN и бесконечности не попадают в сетку
+    bool IsValid() const;
+};
+
+// Тайл (x, y) на уровне zoom: карта делится на 2^zoom x 2^zoom частей
+struct Tile {
+    static constexpr int MAX_ZOOM = 30;
+
+    int zoom = 0;
+    int x = 0;
+    int y = 0;
+
+    // zoom в [0, MAX_ZOOM]: на MAX_ZOOM допуск упрощения маршрутов уже в 2^30 раз
+    // меньше исходного и на ломаные не влияет
+    static int ClampZoom(int zoom);
+
+    // zoom в [0, MAX_ZOOM], x и y в [0, 2^zoom)
+    bool IsValid() const;
+    Viewport GetViewport(double width, double height) const;
+
+    bool operator<(const Tile& other) const {
+        return std::tie(zoom, x, y) < std::tie(other.zoom, other.x, other.y);
+    }
+};
+
+// Упрощение ломаной алгоритмом Дугласа — Пекера: точки, отклоняющиеся от
+// упрощённой линии не больше чем на tolerance, отбрасываются. Концы сохраняются
+std::vector<svg::Point> SimplifyPolyline(const std::vector<svg::Point>& points, double tolerance);
+
+// Равномерная сетка над картой: в каждой ячейке — id объектов,
+// чьи ограничивающие прямоугольники её задевают
+class SpatialGrid {
+public:
+    SpatialGrid(const Viewport& bounds, size_t side);
+
+    void Insert(const Viewport& box, uint32_t id);
+
+    // Кандидаты без повторов в порядке возрастания id
+    std::vector<uint32_t> Query(const Viewport& box) const;
+
+private:
+    size_t CellX(double x) const;
+    size_t CellY(double y) const;
+
+    Viewport bounds_;
+    size_t side_;
+    double cell_width_;
+    double cell_height_;
+    std::vector<std::vector<uint32_t>> cells_;
+};
+
+} // namespace map_renderer
@@ -1,16 +1,145 @@
 #include "map_renderer.h"
 #include "geo.h"
 #include <algorithm>
-#include <unordered_set>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
 #include "json_reader.h"
 
 using namespace map_renderer;
 using namespace transport;
 using namespace svg;
 
-MapRenderer::MapRenderer(json_reader::JsonReader& reader, TransportCatalogue& db) 
+namespace {
+    constexpr size_t ROUTES_PER_TASK = 64;
+    constexpr size_t MAX_GRID_SIDE = 256;
+    // Независимые аккумуляторы минимумов и максимумов: цикл без зависимостей
+    // между итерациями компилятор раскладывает по SIMD-регистрам
+    constexpr size_t LANES = 4;
+}
+
+namespace {
+
+// Рисует каждый элемент ids в отдельную строку. Элементы делятся на части по задачам,
+// каждая часть пишется в один буфер, который затем режется по запомненным границам
+template <typename Render>
+std::vector<std::string> RenderFragments(const std::vector<uint32_t>& ids, const MapDescription& map_description, Render render) {
+    std::vector<std::string> result(ids.size());
+
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunk_count = std::clamp<size_t>(ids.size() / ROUTES_PER_TASK, 1, threads);
+    const size_t chunk_size = (ids.size() + chunk_count - 1) / chunk_count;
+
+    std::vector<std::future<void>> tasks;
+    for (size_t begin = 0; begin < ids.size(); begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, ids.size());
+        tasks.push_back(std::async(std::launch::async, [&ids, &map_description, &result, &render, begin, end] {
+            output::StringStream stream;
+            output::SetNumberFormat(stream, map_description.number_format_);
+            svg::StreamFragment doc(stream);
+
+            std::vector<size_t> offsets{0};
+            std::vector<uint32_t> id(1);
+            for (size_t i = begin; i < end; ++i) {
+                id[0] = ids[i];
+                render(doc, id);
+                offsets.push_back(stream.Size());
+            }
+
+            const std::string data = stream.Release();
+            for (size_t i = begin; i < end; ++i) {
+                result[i] = data.substr(offsets[i - begin], offsets[i - begin + 1] - offsets[i - begin]);
+            }
+        }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+    return result;
+}
+
+}
+
+SphereProjector::SphereProjector(const std::vector<double>& lats, const std::vector<double>& lngs,
+    double max_width, double max_height, double padding)
+    : padding_(padding)
+{
+    const size_t count = std::min(lats.size(), lngs.size());
+    if (count == 0) {
+        return;
+    }
+
+    double min_lat[LANES], max_lat[LANES], min_lon[LANES], max_lon[LANES];
+    std::fill(std::begin(min_lat), std::end(min_lat), lats[0]);
+    std::fill(std::begin(max_lat), std::end(max_lat), lats[0]);
+    std::fill(std::begin(min_lon), std::end(min_lon), lngs[0]);
+    std::fill(std::begin(max_lon), std::end(max_lon), lngs[0]);
+
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            min_lat[lane] = std::min(min_lat[lane], lats[i + lane]);
+            max_lat[lane] = std::max(max_lat[lane], lats[i + lane]);
+            min_lon[lane] = std::min(min_lon[lane], lngs[i + lane]);
+            max_lon[lane] = std::max(max_lon[lane], lngs[i + lane]);
+        }
+    }
+    for (; i < count; ++i) {
+        min_lat[0] = std::min(min_lat[0], lats[i]);
+        max_lat[0] = std::max(max_lat[0], lats[i]);
+        min_lon[0] = std::min(min_lon[0], lngs[i]);
+        max_lon[0] = std::max(max_lon[0], lngs[i]);
+    }
+
+    SetBounds({
+        *std::min_element(std::begin(min_lat), std::end(min_lat)),
+        *std::max_element(std::begin(max_lat), std::end(max_lat)),
+        *std::min_element(std::begin(min_lon), std::end(min_lon)),
+        *std::max_element(std::begin(max_lon), std::end(max_lon))
+    }, max_width, max_height);
+}
+
+void SphereProjector::SetBounds(const Bounds& bounds, double max_width, double max_height) {
+    min_lon_ = bounds.min_lon;
+    max_lat_ = bounds.max_lat;
+
+    std::optional<double> width_zoom;
+    if (!IsZero(bounds.max_lon - bounds.min_lon)) {
+        width_zoom = (max_width - 2 * padding_) / (bounds.max_lon - bounds.min_lon);
+    }
+
+    std::optional<double> height_zoom;
+    if (!IsZero(bounds.max_lat - bounds.min_lat)) {
+        height_zoom = (max_height - 2 * padding_) / (bounds.max_lat - bounds.min_lat);
+    }
+
+    if (width_zoom && height_zoom) {
+        zoom_coeff_ = std::min(*width_zoom, *height_zoom);
+    }
+    else if (width_zoom) {
+        zoom_coeff_ = *width_zoom;
+    }
+    else if (height_zoom) {
+        zoom_coeff_ = *height_zoom;
+    }
+}
+
+void SphereProjector::Project(const double* lats, const double* lngs, size_t count, svg::Point* out) const {
+    const double min_lon = min_lon_;
+    const double max_lat = max_lat_;
+    const double zoom = zoom_coeff_;
+    const double padding = padding_;
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = MulAdd(lngs[i] - min_lon, zoom, padding);
+        out[i].y = MulAdd(max_lat - lats[i], zoom, padding);
+    }
+}
+
+MapRenderer::MapRenderer(const json_reader::JsonReader& reader, const TransportCatalogue& db) 
     : reader_(reader), db_(db) {
-    InitProjector();
+    BuildPlan();
 }
 
 MapDescription MapRenderer::GetMapDescription() const {
@@ -21,40 +150,76 @@ svg::Point MapRenderer::Convert(geo::Coordinates coordinates) const {
     return (*projector_)(coordinates);
 }
 
-std::vector<const transport::Bus*> MapRenderer::GetSortedBuses() const {
-    std::vector<const Bus*> buses;
-    const auto& all_buses = db_.GetAllBuses();
-    buses.reserve(all_buses.size());
-    
-    for (const auto& bus : all_buses) {
-        if (!bus.GetStops().empty()) {
-            buses.push_back(&bus);
-        }
-    }
+std::vector<const transport::Stop*> MapRenderer::GetBusLabelStops(const transport::Bus& bus) const {
+    const auto stops = db_.GetRoute(bus.GetId());
+    std::vector<const Stop*> result{db_.GetStopById(stops.front())};
 
-    std::sort(buses.begin(), buses.end(), BusComparator());
-    return buses;
+    if (!bus.is_round() && stops[stops.size() / 2] != stops[0]) {
+        size_t last_stop_pos = std::ceil(stops.size() / 2.0);
+        result.push_back(db_.GetStopById(stops[last_stop_pos - 1]));
+    }
+    return result;
 }
 
-void MapRenderer::InitProjector() {
-    const auto& all_buses = db_.GetAllBuses();
-    std::vector<geo::Coordinates> all_coordinates;
-    
-    for (const auto& bus : all_buses) {
-        const auto& stops = bus.GetStops();
-        for (const Stop* stop_ptr : stops) {
-            all_coordinates.push_back(stop_ptr->coordinates_);
+void MapRenderer::BuildPlan() {
+    for (const auto& bus : db_.GetAllBuses()) {
+        if (!db_.GetForwardRoute(bus.GetId()).empty()) {
+            plan_.buses.push_back(&bus);
+        }
+    }
+    std::sort(plan_.buses.begin(), plan_.buses.end(), BusComparator());
+
+    // Сортируем уже уникальные остановки, а не все вхождения в маршруты.
+    // Маршруты и координаты читаются из столбцов справочника по StopId
+    constexpr uint32_t NOT_IN_PLAN = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> stop_ids(db_.GetAllStops().size(), NOT_IN_PLAN);
+    for (const Bus* bus : plan_.buses) {
+        for (StopId stop : db_.GetForwardRoute(bus->GetId())) {
+            if (stop_ids[stop] == NOT_IN_PLAN) {
+                stop_ids[stop] = 0;
+                plan_.stops.push_back(db_.GetStopById(stop));
+            }
         }
     }
+    std::sort(plan_.stops.begin(), plan_.stops.end(), StopComparator());
+
+    const auto& coordinates = db_.GetStopCoordinates();
+    std::vector<double> lats(plan_.stops.size());
+    std::vector<double> lngs(plan_.stops.size());
+    for (uint32_t id = 0; id < plan_.stops.size(); ++id) {
+        const StopId stop = plan_.stops[id]->id_;
+        stop_ids[stop] = id;
+        lats[id] = coordinates[stop].lat;
+        lngs[id] = coordinates[stop].lng;
+    }
 
+    // Повторы точек не влияют на границы, поэтому проектор тот же, что и по всем вхождениям
     const MapDescription& md = GetMapDescription();
-    SphereProjector projector(all_coordinates.begin(), all_coordinates.end(), md.width_, md.height_, md.padding_);
-    projector_ = projector;
+    projector_ = SphereProjector(lats, lngs, md.width_, md.height_, md.padding_);
+
+    plan_.stop_points.resize(plan_.stops.size());
+    projector_->Project(lats.data(), lngs.data(), plan_.stops.size(), plan_.stop_points.data());
+
+    plan_.routes.reserve(plan_.buses.size());
+    plan_.labels.reserve(plan_.buses.size());
+    for (const Bus* bus : plan_.buses) {
+        auto& route = plan_.routes.emplace_back();
+        const auto stops = db_.GetRoute(bus->GetId());
+        route.reserve(stops.size());
+        for (StopId stop : stops) {
+            route.push_back(plan_.stop_points[stop_ids[stop]]);
+        }
+
+        auto& labels = plan_.labels.emplace_back();
+        for (const Stop* stop : GetBusLabelStops(*bus)) {
+            labels.push_back(plan_.stop_points[stop_ids[stop->id_]]);
+        }
+    }
 }
 
-svg::Text MapRenderer::CreateBaseText(const std::string& data, svg::Point position, const MapDescription& map_description) const {
+svg::Text MapRenderer::CreateBaseText(std::string_view data, svg::Point position, const MapDescription& map_description) const {
         return Text()
-        .SetData(data)
+        .SetData(std::string(data))
         .SetPosition(position)
         .SetOffset(map_description.stop_label_offset_)
         .SetFontSize(map_description.stop_label_font_size_)
@@ -76,46 +241,35 @@ svg::Text MapRenderer::CreateBusLabel(const std::string& name, svg::Point positi
             .SetFillColor(color);
 }
 
-void MapRenderer::RenderRoutes(Document& doc, const map_renderer::MapDescription& map_description) const {
+template <typename Container>
+void MapRenderer::RenderRoutes(Container& doc, const map_renderer::MapDescription& map_description,
+                               const RouteGeometry& routes, const std::vector<uint32_t>& bus_ids) const {
     const std::vector<Color>& array_of_colors = map_description.color_palette_;
-    auto iterator = array_of_colors.begin();
 
-    const std::vector<const transport::Bus*>& sorted_buses_ptrs = GetSortedBuses();
-    for (const Bus* bus_ptr : sorted_buses_ptrs) {
+    for (uint32_t id : bus_ids) {
         Polyline polyline;
-        polyline.SetStrokeColor(*iterator).SetFillColor(svg::NoneColor).SetStrokeWidth(map_description.line_width_)
+        polyline.SetStrokeColor(array_of_colors[id % array_of_colors.size()]).SetFillColor(svg::NoneColor).SetStrokeWidth(map_description.line_width_)
             .SetStrokeLineCap(StrokeLineCap::ROUND).SetStrokeLineJoin(StrokeLineJoin::ROUND);
 
-        std::vector<const Stop*> stop_ptrs = bus_ptr->GetStops();
-
-        for (const Stop* stop : stop_ptrs) {
-            polyline.AddPoint(Convert(stop->coordinates_));
+        for (svg::Point point : routes[id]) {
+            polyline.AddPoint(point);
         }
 
         doc.Add(polyline);
-
-        if (iterator + 1 == array_of_colors.end()) {
-            iterator = array_of_colors.begin();
-        }
-        else {
-            ++iterator;
-        }
     }
 }
 
-void MapRenderer::RenderBusNames(svg::Document& doc, const map_renderer::MapDescription& map_description) const {
-    std::vector<const Bus*> sorted_buses_ptrs = GetSortedBuses();
-
-    auto cyclic_color_it = map_description.color_palette_.begin();
+template <typename Container>
+void MapRenderer::RenderBusNames(Container& doc, const map_renderer::MapDescription& map_description,
+                                 const std::vector<uint32_t>& bus_ids) const {
+    const std::vector<Color>& array_of_colors = map_description.color_palette_;
 
-    for (const Bus* bus_ptr : sorted_buses_ptrs) {
-        const std::vector<const Stop*>& stops = bus_ptr->GetStops();
-        const Stop* first_stop = stops.front();
+    for (uint32_t id : bus_ids) {
+        const Bus* bus_ptr = plan_.buses[id];
 
         Text label;
 
-        label.SetData(std::string(bus_ptr->GetName()))
-            .SetPosition(Convert(first_stop->coordinates_))
+        label.SetData(bus_ptr->GetName())
             .SetOffset(map_description.bus_label_offset_)
             .SetFontSize(map_description.bus_label_font_size_)
             .SetFontFamily("Verdana")
@@ -128,56 +282,35 @@ void MapRenderer::RenderBusNames(svg::Document& doc, const map_renderer::MapDesc
             .SetStrokeLineCap(StrokeLineCap::ROUND)
             .SetStrokeLineJoin(StrokeLineJoin::ROUND);
 
-        label.SetFillColor(*cyclic_color_it);
+        label.SetFillColor(array_of_colors[id % array_of_colors.size()]);
 
-        doc.Add(underlayer);
-        doc.Add(label);
-
-        if (!(bus_ptr->is_round()) && stops[stops.size() / 2] != stops[0]) {
-            size_t last_stop_pos = std::ceil(stops.size() / 2.0);
-            const Stop* last_stop = stops[last_stop_pos - 1];
-
-            label.SetPosition(Convert(last_stop->coordinates_));
-            underlayer.SetPosition(Convert(last_stop->coordinates_));
-            doc.Add(std::move(underlayer));
-            doc.Add(std::move(label));
-        }
-        if (++cyclic_color_it == map_description.color_palette_.end()) {
-            cyclic_color_it = map_description.color_palette_.begin();
+        for (svg::Point position : plan_.labels[id]) {
+            label.SetPosition(position);
+            underlayer.SetPosition(position);
+            doc.Add(underlayer);
+            doc.Add(label);
         }
     }
 }
 
-void MapRenderer::RenderStops(svg::Document& doc, const map_renderer::MapDescription& map_description) const {
-    std::set<const Stop*, StopComparator> stops_to_draw;
-    const auto& all_buses = db_.GetAllBuses();
-    
-    for (const auto& bus : all_buses) {
-        const auto& stops = bus.GetStops();
-        stops_to_draw.insert(stops.begin(), stops.end());
-    }
-    
-    for (const Stop* stop_ptr : stops_to_draw) {
+template <typename Container>
+void MapRenderer::RenderStops(Container& doc, const map_renderer::MapDescription& map_description,
+                              const std::vector<uint32_t>& stop_ids) const {
+    for (uint32_t id : stop_ids) {
         Circle stop;
-        stop.SetCenter(Convert(stop_ptr->coordinates_))
+        stop.SetCenter(plan_.stop_points[id])
            .SetRadius(map_description.stop_radius_)
            .SetFillColor("white");
         doc.Add(std::move(stop));
     }
 }
 
-void MapRenderer::RenderStopNames(svg::Document& doc, const map_renderer::MapDescription& map_description) const {
-    std::set<const Stop*, StopComparator> stops_to_draw;
-    const auto& all_buses = db_.GetAllBuses();
-    
-    for (const auto& bus : all_buses) {
-        const auto& stops = bus.GetStops();
-        stops_to_draw.insert(stops.begin(), stops.end());
-    }
-    
-    for (const Stop* stop_ptr : stops_to_draw) {
-        Text stop_label = CreateBaseText(stop_ptr->name_, 
-                                       Convert(stop_ptr->coordinates_), 
+template <typename Container>
+void MapRenderer::RenderStopNames(Container& doc, const map_renderer::MapDescription& map_description,
+                                  const std::vector<uint32_t>& stop_ids) const {
+    for (uint32_t id : stop_ids) {
+        Text stop_label = CreateBaseText(plan_.stops[id]->name_, 
+                                       plan_.stop_points[id], 
                                        map_description);
         stop_label.SetFillColor("black");
         
@@ -188,13 +321,285 @@ void MapRenderer::RenderStopNames(svg::Document& doc, const map_renderer::MapDes
     }
 }
 
-svg::Document MapRenderer::RenderMap() const {
-    svg::Document doc;
+template <typename Container>
+void MapRenderer::RenderLayers(Container& doc) const {
     const MapDescription& map_description = GetMapDescription();
 
-    RenderRoutes(doc, map_description);
-    RenderBusNames(doc, map_description);
-    RenderStops(doc, map_description);
-    RenderStopNames(doc, map_description);
+    std::vector<uint32_t> bus_ids(plan_.buses.size());
+    std::iota(bus_ids.begin(), bus_ids.end(), 0);
+    std::vector<uint32_t> stop_ids(plan_.stops.size());
+    std::iota(stop_ids.begin(), stop_ids.end(), 0);
+
+    RenderRoutes(doc, map_description, GetRouteGeometry(0), bus_ids);
+    RenderBusNames(doc, map_description, bus_ids);
+    RenderStops(doc, map_description, stop_ids);
+    RenderStopNames(doc, map_description, stop_ids);
+}
+
+svg::Document MapRenderer::RenderMap() const {
+    svg::Document doc;
+    RenderLayers(doc);
     return doc;
 }
+
+void MapRenderer::RenderMap(std::ostream& out) const {
+    const MapDescription map_description = GetMapDescription();
+    const RouteGeometry& routes = GetRouteGeometry(0);
+
+    std::vector<uint32_t> bus_ids(plan_.buses.size());
+    std::iota(bus_ids.begin(), bus_ids.end(), 0);
+    std::vector<uint32_t> stop_ids(plan_.stops.size());
+    std::iota(stop_ids.begin(), stop_ids.end(), 0);
+
+    // Каждая часть рисуется в свой буфер отдельной задачей,
+    // затем буферы склеиваются в порядке слоёв
+    const auto render_part = [&map_description](auto render) {
+        return std::async(std::launch::async, [&map_description, render] {
+            output::StringStream part;
+            output::SetNumberFormat(part, map_description.number_format_);
+            svg::StreamFragment fragment(part);
+            render(fragment);
+            return part.Release();
+        });
+    };
+
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunk_count = std::clamp<size_t>(bus_ids.size() / ROUTES_PER_TASK, 1, threads);
+    const size_t chunk_size = (bus_ids.size() + chunk_count - 1) / chunk_count;
+
+    std::vector<std::future<std::string>> parts;
+    for (size_t begin = 0; begin < bus_ids.size(); begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, bus_ids.size());
+        std::vector<uint32_t> chunk(bus_ids.begin() + begin, bus_ids.begin() + end);
+        parts.push_back(render_part([this, &map_description, &routes, chunk = std::move(chunk)](svg::StreamFragment& doc) {
+            RenderRoutes(doc, map_description, routes, chunk);
+        }));
+    }
+    parts.push_back(render_part([this, &map_description, &bus_ids](svg::StreamFragment& doc) {
+        RenderBusNames(doc, map_description, bus_ids);
+    }));
+    parts.push_back(render_part([this, &map_description, &stop_ids](svg::StreamFragment& doc) {
+        RenderStops(doc, map_description, stop_ids);
+    }));
+    parts.push_back(render_part([this, &map_description, &stop_ids](svg::StreamFragment& doc) {
+        RenderStopNames(doc, map_description, stop_ids);
+    }));
+
+    svg::StreamDocument doc(out);
+    for (auto& part : parts) {
+        const std::string data = part.get();
+        out.write(data.data(), data.size());
+    }
+    doc.Finish();
+}
+
+void MapRenderer::RenderMap(std::ostream& out, FragmentCache& cache, size_t settings_version) const {
+    const MapDescription map_description = GetMapDescription();
+    if (!(cache.projector_ == projector_) || cache.settings_version_ != settings_version) {
+        cache.routes_.clear();
+        cache.stops_.clear();
+        cache.projector_ = projector_;
+        cache.settings_version_ = settings_version;
+    }
+
+    // Переносим актуальные фрагменты; фрагменты удалённых из плана элементов отбрасываются.
+    // Цвет зависит от места автобуса в отсортированном списке, поэтому при вставке
+    // маршрута в середину перерисовываются те, у кого сменился цвет
+    const size_t palette_size = map_description.color_palette_.size();
+    std::unordered_map<const Bus*, FragmentCache::RouteFragment> routes;
+    routes.reserve(plan_.buses.size());
+    std::vector<uint32_t> dirty_buses;
+    for (uint32_t id = 0; id < plan_.buses.size(); ++id) {
+        const Bus* bus = plan_.buses[id];
+        const size_t version = db_.GetBusVersion(bus);
+        const size_t color = id % palette_size;
+
+        auto& fragment = routes[bus];
+        auto it = cache.routes_.find(bus);
+        if (it != cache.routes_.end() && it->second.version == version && it->second.color == color) {
+            fragment = std::move(it->second);
+        } else {
+            fragment.version = version;
+            fragment.color = color;
+            dirty_buses.push_back(id);
+        }
+    }
+
+    std::unordered_map<const Stop*, FragmentCache::StopFragment> stops;
+    stops.reserve(plan_.stops.size());
+    std::vector<uint32_t> dirty_stops;
+    for (uint32_t id = 0; id < plan_.stops.size(); ++id) {
+        const Stop* stop = plan_.stops[id];
+        const size_t version = db_.GetStopVersion(stop);
+
+        auto& fragment = stops[stop];
+        auto it = cache.stops_.find(stop);
+        if (it != cache.stops_.end() && it->second.version == version) {
+            fragment = std::move(it->second);
+        } else {
+            fragment.version = version;
+            dirty_stops.push_back(id);
+        }
+    }
+
+    cache.routes_ = std::move(routes);
+    cache.stops_ = std::move(stops);
+    cache.stats_.rendered = dirty_buses.size() + dirty_stops.size();
+    cache.stats_.reused = plan_.buses.size() + plan_.stops.size() - cache.stats_.rendered;
+
+    const RouteGeometry& geometry = GetRouteGeometry(0);
+    std::vector<std::string> route_parts = RenderFragments(dirty_buses, map_description,
+        [this, &map_description, &geometry](svg::StreamFragment& doc, const std::vector<uint32_t>& id) {
+            RenderRoutes(doc, map_description, geometry, id);
+        });
+    std::vector<std::string> label_parts = RenderFragments(dirty_buses, map_description,
+        [this, &map_description](svg::StreamFragment& doc, const std::vector<uint32_t>& id) {
+            RenderBusNames(doc, map_description, id);
+        });
+    for (size_t i = 0; i < dirty_buses.size(); ++i) {
+        auto& fragment = cache.routes_.at(plan_.buses[dirty_buses[i]]);
+        fragment.route = std::move(route_parts[i]);
+        fragment.label = std::move(label_parts[i]);
+    }
+
+    std::vector<std::string> circle_parts = RenderFragments(dirty_stops, map_description,
+        [this, &map_description](svg::StreamFragment& doc, const std::vector<uint32_t>& id) {
+            RenderStops(doc, map_description, id);
+        });
+    std::vector<std::string> stop_label_parts = RenderFragments(dirty_stops, map_description,
+        [this, &map_description](svg::StreamFragment& doc, const std::vector<uint32_t>& id) {
+            RenderStopNames(doc, map_description, id);
+        });
+    for (size_t i = 0; i < dirty_stops.size(); ++i) {
+        auto& fragment = cache.stops_.at(plan_.stops[dirty_stops[i]]);
+        fragment.circle = std::move(circle_parts[i]);
+        fragment.label = std::move(stop_label_parts[i]);
+    }
+
+    // Склеиваем фрагменты в порядке слоёв
+    std::vector<const FragmentCache::RouteFragment*> bus_fragments;
+    bus_fragments.reserve(plan_.buses.size());
+    for (const Bus* bus : plan_.buses) {
+        bus_fragments.push_back(&cache.routes_.at(bus));
+    }
+    std::vector<const FragmentCache::StopFragment*> stop_fragments;
+    stop_fragments.reserve(plan_.stops.size());
+    for (const Stop* stop : plan_.stops) {
+        stop_fragments.push_back(&cache.stops_.at(stop));
+    }
+
+    svg::StreamDocument doc(out);
+    for (const auto* fragment : bus_fragments) {
+        out.write(fragment->route.data(), fragment->route.size());
+    }
+    for (const auto* fragment : bus_fragments) {
+        out.write(fragment->label.data(), fragment->label.size());
+    }
+    for (const auto* fragment : stop_fragments) {
+        out.write(fragment->circle.data(), fragment->circle.size());
+    }
+    for (const auto* fragment : stop_fragments) {
+        out.write(fragment->label.data(), fragment->label.size());
+    }
+    doc.Finish();
+}
+
+const MapRenderer::RouteGeometry& MapRenderer::GetRouteGeometry(int zoom) const {
+    // Кэш держит не больше MAX_ZOOM + 1 вариантов геометрии
+    zoom = Tile::ClampZoom(zoom);
+    const double tolerance = GetMapDescription().simplify_tolerance_ / std::ldexp(1.0, zoom);
+    if (tolerance <= 0) {
+        return plan_.routes;
+    }
+
+    std::lock_guard lock(geometry_mutex_);
+    auto [it, inserted] = route_geometry_.try_emplace(zoom);
+    if (inserted) {
+        it->second.reserve(plan_.routes.size());
+        for (const auto& points : plan_.routes) {
+            it->second.push_back(SimplifyPolyline(points, tolerance));
+        }
+    }
+    return it->second;
+}
+
+const MapRenderer::ViewportIndex& MapRenderer::GetViewportIndex() const {
+    std::call_once(index_flag_, [this] {
+        const MapDescription map_description = GetMapDescription();
+        const Viewport bounds{{0, 0}, {map_description.width_, map_description.height_}};
+        const size_t side = std::clamp<size_t>(static_cast<size_t>(std::sqrt(plan_.stops.size() / 4.0)), 1, MAX_GRID_SIDE);
+
+        index_ = std::make_unique<ViewportIndex>(ViewportIndex{
+            SpatialGrid(bounds, side), SpatialGrid(bounds, side), SpatialGrid(bounds, side)
+        });
+        ViewportIndex& index = *index_;
+
+        for (uint32_t id = 0; id < plan_.buses.size(); ++id) {
+            const auto& points = plan_.routes[id];
+            for (size_t i = 0; i + 1 < points.size(); ++i) {
+                Viewport box = Viewport::Around(points[i]);
+                box.Extend(points[i + 1]);
+                index.route_grid.Insert(box, id);
+            }
+            if (points.size() == 1) {
+                index.route_grid.Insert(Viewport::Around(points.front()), id);
+            }
+            for (svg::Point point : plan_.labels[id]) {
+                index.label_grid.Insert(Viewport::Around(point), id);
+            }
+        }
+
+        for (uint32_t id = 0; id < plan_.stops.size(); ++id) {
+            index.stop_grid.Insert(Viewport::Around(plan_.stop_points[id]), id);
+        }
+    });
+    return *index_;
+}
+
+void MapRenderer::RenderViewport(std::ostream& out, const Viewport& viewport, int zoom) const {
+    const MapDescription map_description = GetMapDescription();
+    const ViewportIndex& index = GetViewportIndex();
+
+    // Линии и кружки имеют толщину, поэтому берём область с запасом
+    const Viewport area = viewport.Expanded(std::max({
+        map_description.line_width_, map_description.stop_radius_, map_description.underlayer_width_}));
+
+    std::vector<uint32_t> route_ids = index.route_grid.Query(area);
+    route_ids.erase(std::remove_if(route_ids.begin(), route_ids.end(), [&](uint32_t id) {
+        const auto& points = plan_.routes[id];
+        if (points.size() == 1) {
+            return !area.Contains(points.front());
+        }
+        for (size_t i = 0; i + 1 < points.size(); ++i) {
+            if (area.IntersectsSegment(points[i], points[i + 1])) {
+                return false;
+            }
+        }
+        return true;
+    }), route_ids.end());
+
+    std::vector<uint32_t> label_ids = index.label_grid.Query(area);
+    label_ids.erase(std::remove_if(label_ids.begin(), label_ids.end(), [&](uint32_t id) {
+        const auto& labels = plan_.labels[id];
+        return std::none_of(labels.begin(), labels.end(), [&](svg::Point point) {
+            return area.Contains(point);
+        });
+    }), label_ids.end());
+
+    std::vector<uint32_t> stop_ids = index.stop_grid.Query(area);
+    stop_ids.erase(std::remove_if(stop_ids.begin(), stop_ids.end(), [&](uint32_t id) {
+        return !area.Contains(plan_.stop_points[id]);
+    }), stop_ids.end());
+
+    const output::NumberFormat prev_format = output::GetNumberFormat(out);
+    output::SetNumberFormat(out, map_description.number_format_);
+
+    svg::StreamDocument doc(out);
+    RenderRoutes(doc, map_description, GetRouteGeometry(zoom), route_ids);
+    RenderBusNames(doc, map_description, label_ids);
+    RenderStops(doc, map_description, stop_ids);
+    RenderStopNames(doc, map_description, stop_ids);
+    doc.Finish();
+
+    output::SetNumberFormat(out, prev_format);
+}
\ No newline at end of file
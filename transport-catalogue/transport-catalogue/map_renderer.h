@@ -1,6 +1,13 @@
 #pragma once
 #include "svg.h"
+#include "map_index.h"
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include "geo.h"
 #include "transport_catalogue.h"
 
@@ -30,6 +37,11 @@ struct MapDescription {
     double underlayer_width_{};
 
     std::vector<svg::Color> color_palette_{};
+
+    output::NumberFormat number_format_{};
+
+    // Допуск упрощения маршрутов в пикселях, 0 — без упрощения
+    double simplify_tolerance_{};
 };
 
 inline const double EPSILON = 1e-6;
@@ -37,6 +49,16 @@ inline bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
+// a * b + c; на платформах с аппаратным FMA — одной инструкцией.
+// Скалярная и пакетная проекции считают по этой формуле и совпадают побитово
+inline double MulAdd(double a, double b, double c) {
+#ifdef FP_FAST_FMA
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
 class SphereProjector {
 public:
     template <typename PointInputIt>
@@ -48,79 +70,165 @@ public:
             return;
         }
 
-        const auto [left_it, right_it] = std::minmax_element(
-            points_begin, points_end,
-            [](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
-        min_lon_ = left_it->lng;
-        const double max_lon = right_it->lng;
-
-        const auto [bottom_it, top_it] = std::minmax_element(
-            points_begin, points_end,
-            [](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
-        const double min_lat = bottom_it->lat;
-        max_lat_ = top_it->lat;
-
-        std::optional<double> width_zoom;
-        if (!IsZero(max_lon - min_lon_)) {
-            width_zoom = (max_width - 2 * padding) / (max_lon - min_lon_);
-        }
-
-        std::optional<double> height_zoom;
-        if (!IsZero(max_lat_ - min_lat)) {
-            height_zoom = (max_height - 2 * padding) / (max_lat_ - min_lat);
-        }
-
-        if (width_zoom && height_zoom) {
-            zoom_coeff_ = std::min(*width_zoom, *height_zoom);
-        }
-        else if (width_zoom) {
-            zoom_coeff_ = *width_zoom;
-        }
-        else if (height_zoom) {
-            zoom_coeff_ = *height_zoom;
+        Bounds bounds{points_begin->lat, points_begin->lat, points_begin->lng, points_begin->lng};
+        for (auto it = points_begin; it != points_end; ++it) {
+            bounds.min_lat = std::min(bounds.min_lat, it->lat);
+            bounds.max_lat = std::max(bounds.max_lat, it->lat);
+            bounds.min_lon = std::min(bounds.min_lon, it->lng);
+            bounds.max_lon = std::max(bounds.max_lon, it->lng);
         }
+        SetBounds(bounds, max_width, max_height);
     }
 
+    // Точки в виде отдельных массивов широт и долгот одинаковой длины
+    SphereProjector(const std::vector<double>& lats, const std::vector<double>& lngs,
+        double max_width, double max_height, double padding);
+
     svg::Point operator()(geo::Coordinates coords) const {
         return {
-            (coords.lng - min_lon_) * zoom_coeff_ + padding_,
-            (max_lat_ - coords.lat) * zoom_coeff_ + padding_
+            MulAdd(coords.lng - min_lon_, zoom_coeff_, padding_),
+            MulAdd(max_lat_ - coords.lat, zoom_coeff_, padding_)
         };
     }
 
+    // Пакетная проекция count точек в out, результат совпадает с operator()
+    void Project(const double* lats, const double* lngs, size_t count, svg::Point* out) const;
+
+    bool operator==(const SphereProjector& other) const {
+        return padding_ == other.padding_ && min_lon_ == other.min_lon_
+            && max_lat_ == other.max_lat_ && zoom_coeff_ == other.zoom_coeff_;
+    }
+
 private:
+    struct Bounds {
+        double min_lat;
+        double max_lat;
+        double min_lon;
+        double max_lon;
+    };
+
+    void SetBounds(const Bounds& bounds, double max_width, double max_height);
+
     double padding_;
     double min_lon_ = 0;
     double max_lat_ = 0;
     double zoom_coeff_ = 0;
 };
 
+// svg-фрагменты отдельных маршрутов и остановок, переживающие пересборку MapRenderer.
+// Фрагмент перерисовывается, только если изменились его входные данные:
+// версия автобуса или остановки, цвет из палитры, проекция или настройки отрисовки
+class FragmentCache {
+public:
+    struct Stats {
+        size_t reused = 0;
+        size_t rendered = 0;
+    };
+
+    // Сколько фрагментов взято из кэша и перерисовано при последней отрисовке
+    Stats GetLastStats() const {
+        return stats_;
+    }
+
+private:
+    friend class MapRenderer;
+
+    struct RouteFragment {
+        size_t version = 0;
+        size_t color = 0;
+        std::string route;
+        std::string label;
+    };
+
+    struct StopFragment {
+        size_t version = 0;
+        std::string circle;
+        std::string label;
+    };
+
+    std::optional<SphereProjector> projector_;
+    size_t settings_version_ = 0;
+    std::unordered_map<const transport::Bus*, RouteFragment> routes_;
+    std::unordered_map<const transport::Stop*, StopFragment> stops_;
+    Stats stats_;
+};
+
 class MapRenderer {
 public: 
 
-    MapRenderer(json_reader::JsonReader& reader, transport::TransportCatalogue& db);
+    MapRenderer(const json_reader::JsonReader& reader, const transport::TransportCatalogue& db);
 
     MapDescription GetMapDescription() const;
     svg::Point Convert(geo::Coordinates coordinates) const;
 
     svg::Document RenderMap() const;
-    svg::Text CreateBaseText(const std::string& data, svg::Point position, const map_renderer::MapDescription& map_description) const;
+    // Выводит карту сразу в поток, не строя svg::Document
+    void RenderMap(std::ostream& out) const;
+    // То же, но переиспользует фрагменты прошлых отрисовок и дополняет cache новыми.
+    // settings_version — номер настроек отрисовки, при его смене кэш сбрасывается
+    void RenderMap(std::ostream& out, FragmentCache& cache, size_t settings_version) const;
+    // Выводит только элементы, задевающие viewport; координаты те же, что у полной карты
+    void RenderViewport(std::ostream& out, const Viewport& viewport, int zoom = 0) const;
+    svg::Text CreateBaseText(std::string_view data, svg::Point position, const map_renderer::MapDescription& map_description) const;
     svg::Text CreateUnderlayer(const svg::Text& base_text, const map_renderer::MapDescription& map_description) const;
     svg::Text CreateBusLabel(const std::string& name, svg::Point position, const svg::Color& color, const map_renderer::MapDescription& map_description) const;
 
 private:
+    // Всё, что нужно слоям: автобусы и остановки в порядке отрисовки и их точки на карте.
+    // Строится один раз в конструкторе, каждая остановка проецируется ровно один раз
+    struct RenderPlan {
+        std::vector<const transport::Bus*> buses;
+        std::vector<const transport::Stop*> stops;
+        std::vector<std::vector<svg::Point>> routes;
+        std::vector<std::vector<svg::Point>> labels;
+        std::vector<svg::Point> stop_points;
+    };
+
+    // Пространственный индекс элементов плана, строится при первом запросе viewport
+    struct ViewportIndex {
+        SpatialGrid route_grid;
+        SpatialGrid label_grid;
+        SpatialGrid stop_grid;
+    };
+
+    using RouteGeometry = std::vector<std::vector<svg::Point>>;
+
+    void BuildPlan();
+    const ViewportIndex& GetViewportIndex() const;
+    // Точки маршрутов по индексам plan_.buses, упрощённые для уровня zoom:
+    // на уровне z карта увеличена в 2^z раз, поэтому допуск в координатах карты меньше
+    const RouteGeometry& GetRouteGeometry(int zoom) const;
+
+    // Остановки, у которых подписывается автобус: первая и, для некольцевого, конечная
+    std::vector<const transport::Stop*> GetBusLabelStops(const transport::Bus& bus) const;
+
+    // Container — svg::Document, svg::StreamDocument или svg::StreamFragment.
+    // bus_ids и stop_ids — индексы в plan_, по индексу автобуса же выбирается цвет
+    template <typename Container>
+    void RenderLayers(Container& doc) const;
+    template <typename Container>
+    void RenderRoutes(Container& doc, const map_renderer::MapDescription& map_description,
+                      const RouteGeometry& routes, const std::vector<uint32_t>& bus_ids) const; // вспомогательная фнукия
+    template <typename Container>
+    void RenderBusNames(Container& doc, const map_renderer::MapDescription& map_description,
+                        const std::vector<uint32_t>& bus_ids) const;
+    template <typename Container>
+    void RenderStops(Container& doc, const map_renderer::MapDescription& map_description,
+                     const std::vector<uint32_t>& stop_ids) const;
+    template <typename Container>
+    void RenderStopNames(Container& doc, const map_renderer::MapDescription& map_description,
+                         const std::vector<uint32_t>& stop_ids) const;
 
-    void InitProjector();
+    std::optional<SphereProjector> projector_;   
+    const json_reader::JsonReader& reader_;
+    const transport::TransportCatalogue& db_;    
+    RenderPlan plan_;
 
-    std::vector<const transport::Bus*> GetSortedBuses() const;
-    void RenderRoutes(svg::Document& doc, const map_renderer::MapDescription& map_description) const; // вспомогательная фнукия
-    void RenderBusNames(svg::Document& doc, const map_renderer::MapDescription& map_description) const;
-    void RenderStops(svg::Document& doc, const map_renderer::MapDescription& map_description) const;
-    void RenderStopNames(svg::Document& doc, const map_renderer::MapDescription& map_description) const;
+    mutable std::once_flag index_flag_;
+    mutable std::unique_ptr<ViewportIndex> index_;
 
-    std::optional<SphereProjector> projector_;   
-    json_reader::JsonReader& reader_;
-    transport::TransportCatalogue& db_;    
+    mutable std::mutex geometry_mutex_;
+    mutable std::map<int, RouteGeometry> route_geometry_;
 };
 
 } 
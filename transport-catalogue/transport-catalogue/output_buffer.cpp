@@ -0,0 +1,141 @@
+#include "output_buffer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace output {
+
+namespace {
+    constexpr size_t INITIAL_CAPACITY = 4096;
+
+    int ModeIndex() {
+        static const int index = std::ios_base::xalloc();
+        return index;
+    }
+
+    int PrecisionIndex() {
+        static const int index = std::ios_base::xalloc();
+        return index;
+    }
+
+    void TrimFractionZeros(char* begin, char*& end) {
+        if (std::memchr(begin, '.', end - begin) == nullptr) {
+            return;
+        }
+        while (end[-1] == '0') {
+            --end;
+        }
+        if (end[-1] == '.') {
+            --end;
+        }
+    }
+}
+
+void SetNumberFormat(std::ostream& out, NumberFormat format) {
+    out.iword(ModeIndex()) = static_cast<long>(format.mode);
+    out.iword(PrecisionIndex()) = format.precision;
+}
+
+NumberFormat GetNumberFormat(std::ostream& out) {
+    NumberFormat format;
+    format.mode = static_cast<NumberMode>(out.iword(ModeIndex()));
+    if (format.mode == NumberMode::FIXED) {
+        format.precision = static_cast<int>(out.iword(PrecisionIndex()));
+    }
+    return format;
+}
+
+void WriteNumber(std::ostream& out, double value) {
+    // Хватает для любого double в режимах DEFAULT и SHORTEST;
+    // для очень больших чисел в FIXED уходим в обычный operator<<
+    char buffer[128];
+    char* end = buffer + sizeof(buffer);
+    std::to_chars_result result;
+
+    const NumberFormat format = GetNumberFormat(out);
+    switch (format.mode) {
+    case NumberMode::SHORTEST:
+        result = std::to_chars(buffer, end, value);
+        break;
+    case NumberMode::FIXED:
+        result = std::to_chars(buffer, end, value, std::chars_format::fixed, format.precision);
+        if (result.ec == std::errc{}) {
+            TrimFractionZeros(buffer, result.ptr);
+        }
+        break;
+    default:
+        result = std::to_chars(buffer, end, value, std::chars_format::general, 6);
+        break;
+    }
+
+    if (result.ec != std::errc{}) {
+        out << value;
+        return;
+    }
+    out.write(buffer, result.ptr - buffer);
+}
+
+void WriteNumber(std::ostream& out, int value) {
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.write(buffer, result.ptr - buffer);
+}
+
+StringBuffer::StringBuffer() {
+    Grow(INITIAL_CAPACITY);
+}
+
+size_t StringBuffer::Size() const {
+    return pptr() - pbase();
+}
+
+std::string StringBuffer::Release() {
+    data_.resize(pptr() - pbase());
+    std::string result = std::move(data_);
+    data_.clear();
+    setp(nullptr, nullptr);
+    Grow(INITIAL_CAPACITY);
+    return result;
+}
+
+void StringBuffer::Grow(size_t min_free) {
+    const size_t used = pptr() - pbase();
+    data_.resize(std::max(data_.size() * 2, used + min_free));
+    setp(data_.data(), data_.data() + data_.size());
+    pbump(static_cast<int>(used));
+}
+
+StringBuffer::int_type StringBuffer::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    Grow(1);
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+std::streamsize StringBuffer::xsputn(const char* data, std::streamsize count) {
+    if (epptr() - pptr() < count) {
+        Grow(count);
+    }
+    std::memcpy(pptr(), data, count);
+    pbump(static_cast<int>(count));
+    return count;
+}
+
+StringStream::StringStream()
+    : std::ostream(nullptr) {
+    rdbuf(&buffer_);
+}
+
+size_t StringStream::Size() const {
+    return buffer_.Size();
+}
+
+std::string StringStream::Release() {
+    return buffer_.Release();
+}
+
+} // namespace output
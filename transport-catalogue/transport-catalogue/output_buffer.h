@@ -0,0 +1,60 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace output {
+
+enum class NumberMode {
+    DEFAULT,    // как std::ostream по умолчанию: 6 значащих цифр
+    SHORTEST,   // кратчайшая запись, по которой число восстанавливается точно
+    FIXED       // precision знаков после точки, хвостовые нули отбрасываются
+};
+
+struct NumberFormat {
+    NumberMode mode = NumberMode::DEFAULT;
+    int precision = 6;
+};
+
+// Формат хранится в самом потоке (ios_base::iword), поэтому svg и json
+// подхватывают его без передачи дополнительных параметров
+void SetNumberFormat(std::ostream& out, NumberFormat format);
+NumberFormat GetNumberFormat(std::ostream& out);
+
+// Выводят число через std::to_chars, минуя локаль и num_put
+void WriteNumber(std::ostream& out, double value);
+void WriteNumber(std::ostream& out, int value);
+
+// Буфер, пишущий прямо в std::string. В отличие от std::ostringstream
+// готовую строку можно забрать без копирования
+class StringBuffer : public std::streambuf {
+public:
+    StringBuffer();
+
+    // Сколько символов записано с последнего Release
+    size_t Size() const;
+    std::string Release();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+private:
+    void Grow(size_t min_free);
+
+    std::string data_;
+};
+
+class StringStream : public std::ostream {
+public:
+    StringStream();
+
+    size_t Size() const;
+    std::string Release();
+
+private:
+    StringBuffer buffer_;
+};
+
+} // namespace output
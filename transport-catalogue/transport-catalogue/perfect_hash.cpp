@@ -0,0 +1,207 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace transport {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+// Средний размер корзины: чем больше, тем компактнее таблица и дольше построение
+constexpr size_t KEYS_PER_BUCKET = 2;
+constexpr int32_t MAX_DISPLACEMENT = 1 << 22;
+constexpr uint64_t MAX_SEEDS = 64;
+
+// Финализатор splitmix64
+uint64_t Mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+uint64_t Displace(uint64_t hash, int32_t displacement) {
+    return Mix(hash + static_cast<uint64_t>(displacement) * 0x9e3779b97f4a7c15ULL);
+}
+
+// Отображение хеша в [0, range) умножением вместо медленного деления, range < 2^32
+size_t Reduce(uint64_t hash, size_t range) {
+    return static_cast<size_t>(((hash >> 32) * range) >> 32);
+}
+
+size_t BucketCount(size_t key_count) {
+    return std::max<size_t>(1, (key_count + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET);
+}
+
+}
+
+uint64_t PerfectHash::HashKey(std::string_view key, uint64_t seed) {
+    // FNV-1a: результат одинаков на всех платформах, в отличие от std::hash
+    uint64_t hash = FNV_OFFSET ^ Mix(seed);
+    for (const char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+PerfectHash::PerfectHash(const std::vector<std::string_view>& keys) {
+    for (seed_ = 0; seed_ < MAX_SEEDS; ++seed_) {
+        if (TryBuild(keys)) {
+            return;
+        }
+    }
+    throw std::invalid_argument("PerfectHash: keys must be distinct");
+}
+
+bool PerfectHash::TryBuild(const std::vector<std::string_view>& keys) {
+    const size_t size = keys.size();
+    if (size > UINT32_MAX) {
+        throw std::length_error("PerfectHash: too many keys");
+    }
+    size_ = size;
+    displacements_.clear();
+    if (size == 0) {
+        return true;
+    }
+
+    const size_t bucket_count = BucketCount(size);
+    std::vector<uint64_t> hashes(size);
+    std::vector<uint32_t> bucket_of(size);
+    std::vector<uint32_t> bucket_starts(bucket_count + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        hashes[i] = HashKey(keys[i], seed_);
+        bucket_of[i] = static_cast<uint32_t>(Reduce(Mix(hashes[i]), bucket_count));
+        ++bucket_starts[bucket_of[i] + 1];
+    }
+    std::partial_sum(bucket_starts.begin(), bucket_starts.end(), bucket_starts.begin());
+
+    std::vector<uint32_t> by_bucket(size);
+    std::vector<uint32_t> next(bucket_starts.begin(), bucket_starts.end() - 1);
+    for (size_t i = 0; i < size; ++i) {
+        by_bucket[next[bucket_of[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    // Большие корзины размещаются первыми, пока свободных ячеек много
+    std::vector<uint32_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&bucket_starts](uint32_t lhs, uint32_t rhs) {
+        return bucket_starts[lhs + 1] - bucket_starts[lhs] > bucket_starts[rhs + 1] - bucket_starts[rhs];
+    });
+
+    displacements_.assign(bucket_count, 0);
+    std::vector<bool> occupied(size, false);
+    std::vector<size_t> slots;
+    size_t free_slot = 0;
+    for (const uint32_t bucket : order) {
+        const uint32_t first = bucket_starts[bucket];
+        const uint32_t last = bucket_starts[bucket + 1];
+        if (first == last) {
+            break;
+        }
+        if (last - first == 1) {
+            // Одиночный ключ кладётся в любую свободную ячейку без подбора
+            while (occupied[free_slot]) {
+                ++free_slot;
+            }
+            occupied[free_slot] = true;
+            displacements_[bucket] = -static_cast<int32_t>(free_slot) - 1;
+            continue;
+        }
+
+        for (uint32_t i = first; i < last; ++i) {
+            for (uint32_t j = first; j < i; ++j) {
+                if (hashes[by_bucket[i]] == hashes[by_bucket[j]]) {
+                    // Совпавшие хеши не развести смещением: пробуем другой seed
+                    return false;
+                }
+            }
+        }
+
+        bool placed = false;
+        for (int32_t displacement = 0; displacement < MAX_DISPLACEMENT && !placed; ++displacement) {
+            slots.clear();
+            placed = true;
+            for (uint32_t i = first; i < last && placed; ++i) {
+                const size_t slot = Reduce(Displace(hashes[by_bucket[i]], displacement), size);
+                placed = !occupied[slot] && std::find(slots.begin(), slots.end(), slot) == slots.end();
+                slots.push_back(slot);
+            }
+            if (placed) {
+                for (const size_t slot : slots) {
+                    occupied[slot] = true;
+                }
+                displacements_[bucket] = displacement;
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PerfectHash::operator()(std::string_view key) const {
+    if (displacements_.empty()) {
+        return 0;
+    }
+    const uint64_t hash = HashKey(key, seed_);
+    const int32_t displacement = displacements_[Reduce(Mix(hash), displacements_.size())];
+    if (displacement < 0) {
+        return static_cast<size_t>(-(displacement + 1));
+    }
+    return Reduce(Displace(hash, displacement), size_);
+}
+
+size_t PerfectHash::Size() const {
+    return size_;
+}
+
+void PerfectHash::Serialize(std::ostream& out) const {
+    const uint64_t header[] = {size_, seed_, displacements_.size()};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(displacements_.data()),
+              static_cast<std::streamsize>(displacements_.size() * sizeof(int32_t)));
+}
+
+PerfectHash PerfectHash::Deserialize(std::istream& in) {
+    uint64_t header[3];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))
+        || header[0] > UINT32_MAX
+        || header[2] != (header[0] == 0 ? 0 : BucketCount(header[0]))) {
+        throw std::runtime_error("PerfectHash: bad header");
+    }
+
+    PerfectHash result;
+    result.size_ = header[0];
+    result.seed_ = header[1];
+    // Читается частями, чтобы обрезанный файл не заставил выделить память
+    // под весь заявленный размер
+    constexpr size_t CHUNK = 4096;
+    int32_t chunk[CHUNK];
+    for (uint64_t left = header[2]; left > 0;) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(left, CHUNK));
+        if (!in.read(reinterpret_cast<char*>(chunk), static_cast<std::streamsize>(count * sizeof(int32_t)))) {
+            throw std::runtime_error("PerfectHash: truncated data");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            // Одиночная корзина должна указывать внутрь таблицы, иначе
+            // operator() вернёт номер за пределами [0, Size())
+            const int32_t displacement = chunk[i];
+            if (displacement >= MAX_DISPLACEMENT
+                || (displacement < 0 && static_cast<uint64_t>(-(static_cast<int64_t>(displacement) + 1)) >= result.size_)) {
+                throw std::runtime_error("PerfectHash: bad displacement");
+            }
+        }
+        result.displacements_.insert(result.displacements_.end(), chunk, chunk + count);
+        left -= count;
+    }
+    return result;
+}
+
+} // namespace transport
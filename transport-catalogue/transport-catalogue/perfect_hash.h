@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+// Минимальная совершенная хеш-функция для неизменного набора строк
+// (hash and displace, как в CHD): ключи делятся на корзины, и для каждой
+// корзины подбирается смещение, при котором её ключи попадают в свободные ячейки.
+// Ключ не из набора тоже получает какой-то номер, поэтому его надо сверять.
+class PerfectHash {
+public:
+    PerfectHash() = default;
+    // Ключи должны быть различны
+    explicit PerfectHash(const std::vector<std::string_view>& keys);
+
+    // Номер ключа в [0, Size())
+    size_t operator()(std::string_view key) const;
+    size_t Size() const;
+
+    // Двоичный формат в порядке байт платформы: размер, seed, смещения корзин.
+    // Сам хеш от стандартной библиотеки не зависит, поэтому сохранённая функция
+    // остаётся верной в другой сборке. Deserialize проверяет, что каждый ключ
+    // попадает в [0, Size()), и бросает std::runtime_error на испорченных данных
+    void Serialize(std::ostream& out) const;
+    static PerfectHash Deserialize(std::istream& in);
+
+private:
+    static uint64_t HashKey(std::string_view key, uint64_t seed);
+    bool TryBuild(const std::vector<std::string_view>& keys);
+
+    size_t size_ = 0;
+    uint64_t seed_ = 0;
+    // >= 0 — смещение корзины, < 0 — корзина из одного ключа в ячейке -value - 1
+    std::vector<int32_t> displacements_;
+};
+
+// Таблица имён, замороженная после загрузки справочника. Поиск — одно
+// вычисление PerfectHash и одно сравнение строк
+template <typename Value>
+class FrozenNameTable {
+public:
+    FrozenNameTable() = default;
+    // Имена должны быть различны и жить не меньше таблицы
+    explicit FrozenNameTable(const std::vector<std::pair<std::string_view, Value>>& entries);
+
+    const Value* Find(std::string_view name) const;
+
+private:
+    // Имя и значение рядом, чтобы поиск читал одну строку кэша
+    struct Entry {
+        std::string_view name;
+        Value value;
+    };
+
+    PerfectHash hash_;
+    std::vector<Entry> entries_;
+};
+
+template <typename Value>
+FrozenNameTable<Value>::FrozenNameTable(const std::vector<std::pair<std::string_view, Value>>& entries) {
+    std::vector<std::string_view> names;
+    names.reserve(entries.size());
+    for (const auto& [name, value] : entries) {
+        names.push_back(name);
+    }
+    hash_ = PerfectHash(names);
+
+    entries_.resize(entries.size());
+    for (const auto& [name, value] : entries) {
+        entries_[hash_(name)] = Entry{name, value};
+    }
+}
+
+template <typename Value>
+const Value* FrozenNameTable<Value>::Find(std::string_view name) const {
+    if (entries_.empty()) {
+        return nullptr;
+    }
+    const Entry& entry = entries_[hash_(name)];
+    return entry.name == name ? &entry.value : nullptr;
+}
+
+} // namespace transport
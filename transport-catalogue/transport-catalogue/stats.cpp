@@ -0,0 +1,250 @@
+#include "stats.h"
+
+#include "json_builder.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stats {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Корзина i хранит длительности из [2^(i-1), 2^i) микросекунд
+constexpr size_t BUCKETS = 40;
+
+struct Histogram {
+    std::array<int64_t, BUCKETS> buckets{};
+    int64_t count = 0;
+    int64_t sum = 0;
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = 0;
+    int64_t allocations = 0;
+
+    void Add(int64_t value) {
+        size_t bucket = 0;
+        while (bucket + 1 < BUCKETS && (int64_t{1} << bucket) <= value) {
+            ++bucket;
+        }
+        ++buckets[bucket];
+        ++count;
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+
+    // Верхняя граница корзины, в которую попал процентиль p
+    int64_t Percentile(double p) const {
+        const auto rank = static_cast<int64_t>(p / 100.0 * count + 0.5);
+        int64_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += buckets[bucket];
+            if (seen >= std::max<int64_t>(rank, 1)) {
+                return std::min(int64_t{1} << bucket, max);
+            }
+        }
+        return max;
+    }
+};
+
+struct TraceEvent {
+    const char* name;
+    int64_t start;
+    int64_t duration;
+    size_t thread;
+};
+
+struct Registry {
+    std::mutex mutex;
+    Clock::time_point origin = Clock::now();
+    std::map<std::string, int64_t, std::less<>> counters;
+    std::map<std::string, int64_t, std::less<>> gauges;
+    std::map<std::string, Histogram, std::less<>> histograms;
+    std::vector<TraceEvent> trace;
+    std::map<std::thread::id, size_t> threads;
+};
+
+std::atomic<bool> enabled{false};
+std::atomic<bool> tracing{false};
+// Вне реестра: operator new не может брать его мьютекс и выделять память
+std::atomic<int64_t> allocations{0};
+std::atomic<int64_t> allocated_bytes{0};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+// В json::Node нет 64-битных целых; большие значения уходят в double
+json::Node::Value ToNode(int64_t value) {
+    if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+        return static_cast<int>(value);
+    }
+    return static_cast<double>(value);
+}
+
+int64_t Microseconds(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+}
+
+void Enable(bool with_trace) {
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        registry.origin = Clock::now();
+    }
+    tracing.store(with_trace, std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+bool IsEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Reset() {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.origin = Clock::now();
+    registry.counters.clear();
+    registry.gauges.clear();
+    registry.histograms.clear();
+    registry.trace.clear();
+    registry.threads.clear();
+    allocations.store(0, std::memory_order_relaxed);
+    allocated_bytes.store(0, std::memory_order_relaxed);
+}
+
+void Count(std::string_view name, int64_t value) {
+    if (!IsEnabled()) {
+        return;
+    }
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    auto it = registry.counters.find(name);
+    if (it == registry.counters.end()) {
+        it = registry.counters.emplace(std::string(name), 0).first;
+    }
+    it->second += value;
+}
+
+void SetGauge(std::string_view name, int64_t value) {
+    if (!IsEnabled()) {
+        return;
+    }
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    auto it = registry.gauges.find(name);
+    if (it == registry.gauges.end()) {
+        registry.gauges.emplace(std::string(name), value);
+    } else {
+        it->second = value;
+    }
+}
+
+void RecordAllocation(size_t bytes) {
+    if (!IsEnabled()) {
+        return;
+    }
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+ScopedTimer::ScopedTimer(const char* name)
+    : name_(name)
+    , active_(IsEnabled()) {
+    if (active_) {
+        start_ = Clock::now();
+        allocations_ = allocations.load(std::memory_order_relaxed);
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (!active_) {
+        return;
+    }
+    const Clock::time_point finish = Clock::now();
+    const int64_t duration = Microseconds(finish - start_);
+    const int64_t allocated = allocations.load(std::memory_order_relaxed) - allocations_;
+
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    auto it = registry.histograms.find(std::string_view(name_));
+    if (it == registry.histograms.end()) {
+        it = registry.histograms.emplace(name_, Histogram{}).first;
+    }
+    it->second.Add(duration);
+    it->second.allocations += allocated;
+
+    if (tracing.load(std::memory_order_relaxed)) {
+        const auto [thread, inserted] = registry.threads.emplace(std::this_thread::get_id(), registry.threads.size());
+        registry.trace.push_back({name_, Microseconds(start_ - registry.origin), duration, thread->second});
+    }
+}
+
+void WriteReport(std::ostream& out) {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    auto counters = registry.counters;
+    counters["memory.allocated_bytes"] = allocated_bytes.load(std::memory_order_relaxed);
+    counters["memory.allocations"] = allocations.load(std::memory_order_relaxed);
+
+    json::Builder builder;
+    builder.StartDict().Key("counters").StartDict();
+    for (const auto& [name, value] : counters) {
+        builder.Key(name).Value(ToNode(value));
+    }
+    builder.EndDict().Key("gauges").StartDict();
+    for (const auto& [name, value] : registry.gauges) {
+        builder.Key(name).Value(ToNode(value));
+    }
+    builder.EndDict().Key("timers").StartDict();
+    for (const auto& [name, histogram] : registry.histograms) {
+        builder.Key(name).StartDict()
+            .Key("allocations").Value(ToNode(histogram.allocations))
+            .Key("count").Value(ToNode(histogram.count))
+            .Key("total_us").Value(ToNode(histogram.sum))
+            .Key("min_us").Value(ToNode(histogram.min))
+            .Key("max_us").Value(ToNode(histogram.max))
+            .Key("p50_us").Value(ToNode(histogram.Percentile(50)))
+            .Key("p90_us").Value(ToNode(histogram.Percentile(90)))
+            .Key("p99_us").Value(ToNode(histogram.Percentile(99)))
+            .EndDict();
+    }
+    builder.EndDict().EndDict();
+
+    json::Print(json::Document(builder.Build()), out);
+}
+
+void WriteTrace(std::ostream& out) {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    json::Builder builder;
+    builder.StartDict().Key("traceEvents").StartArray();
+    for (const TraceEvent& event : registry.trace) {
+        builder.StartDict()
+            .Key("name").Value(std::string(event.name))
+            .Key("ph").Value(std::string("X"))
+            .Key("ts").Value(ToNode(event.start))
+            .Key("dur").Value(ToNode(event.duration))
+            .Key("pid").Value(1)
+            .Key("tid").Value(static_cast<int>(event.thread))
+            .EndDict();
+    }
+    builder.EndArray().EndDict();
+
+    json::Print(json::Document(builder.Build()), out);
+}
+
+} // namespace stats
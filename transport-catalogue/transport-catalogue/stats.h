@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// Замеры времени и счётчики. По умолчанию сбор выключен,
+// и каждая точка замера стоит одной проверки флага
+namespace stats {
+
+// with_trace — дополнительно запоминать каждый замер для trace-файла
+void Enable(bool with_trace = false);
+bool IsEnabled();
+void Reset();
+
+// Прибавляет value к счётчику name
+void Count(std::string_view name, int64_t value = 1);
+// Запоминает последнее значение name (размеры графа, справочника)
+void SetGauge(std::string_view name, int64_t value);
+
+// Учитывает выделение памяти в счётчиках memory.allocations и memory.allocated_bytes.
+// Вызывается из замещённого operator new программы, поэтому сам память не выделяет
+void RecordAllocation(size_t bytes);
+
+// Время жизни объекта попадает в гистограмму name, в микросекундах, а число
+// выделений памяти за это время — в её allocations. При параллельной работе
+// туда попадают и выделения других потоков.
+// name должен жить до конца программы, обычно это строковый литерал
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* name_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_;
+    int64_t allocations_ = 0;
+};
+
+// Отчёт в JSON: счётчики, значения и гистограммы с процентилями
+void WriteReport(std::ostream& out);
+// Замеры в формате Chrome trace events (chrome://tracing, Perfetto)
+void WriteTrace(std::ostream& out);
+
+} // namespace stats
@@ -0,0 +1,212 @@
+#define _USE_MATH_DEFINES
+#include "stop_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace transport {
+
+namespace {
+
+constexpr double STOPS_PER_CELL = 2.0;
+constexpr size_t MAX_GRID_SIDE = 1 << 16;
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+constexpr double METERS_PER_DEGREE = geo::RADIUS_OF_EATH * DEG_TO_RAD;
+
+bool IsCloser(const NearbyStop& lhs, const NearbyStop& rhs) {
+    return std::tie(lhs.distance, lhs.stop->name_) < std::tie(rhs.distance, rhs.stop->name_);
+}
+
+size_t GridSide(double extent, double side) {
+    if (side <= 0) {
+        return 1;
+    }
+    return std::clamp<size_t>(static_cast<size_t>(extent / side) + 1, 1, MAX_GRID_SIDE);
+}
+
+}
+
+StopIndex::StopIndex(const TransportCatalogue& catalogue) {
+    // Только столбец координат, сами остановки нужны лишь для указателей в stops_
+    const auto& points = catalogue.GetStopCoordinates();
+    if (points.empty()) {
+        cell_starts_.assign(2, 0);
+        return;
+    }
+
+    min_lat_ = min_lng_ = std::numeric_limits<double>::max();
+    double max_lat = std::numeric_limits<double>::lowest();
+    double max_lng = std::numeric_limits<double>::lowest();
+    for (const geo::Coordinates& point : points) {
+        min_lat_ = std::min(min_lat_, point.lat);
+        min_lng_ = std::min(min_lng_, point.lng);
+        max_lat = std::max(max_lat, point.lat);
+        max_lng = std::max(max_lng, point.lng);
+    }
+    max_abs_lat_ = std::max(std::abs(min_lat_), std::abs(max_lat));
+
+    // Ячейки примерно квадратные в метрах
+    const double middle_cos = std::max(std::cos((min_lat_ + max_lat) / 2 * DEG_TO_RAD), 0.01);
+    const double height = (max_lat - min_lat_) * METERS_PER_DEGREE;
+    const double width = (max_lng - min_lng_) * METERS_PER_DEGREE * middle_cos;
+    const double cells = std::max(1.0, points.size() / STOPS_PER_CELL);
+    const double side = height > 0 && width > 0 ? std::sqrt(height * width / cells) : std::max(height, width) / cells;
+
+    rows_ = GridSide(height, side);
+    columns_ = GridSide(width, side);
+    if (max_lat > min_lat_) {
+        cell_lat_ = (max_lat - min_lat_) / rows_;
+    }
+    if (max_lng > min_lng_) {
+        cell_lng_ = (max_lng - min_lng_) / columns_;
+    }
+
+    // Сортировка подсчётом по номеру ячейки
+    std::vector<uint32_t> cell_of_stop;
+    cell_of_stop.reserve(points.size());
+    cell_starts_.assign(rows_ * columns_ + 1, 0);
+    for (const geo::Coordinates& point : points) {
+        const size_t cell = CellRow(point.lat) * columns_ + CellColumn(point.lng);
+        cell_of_stop.push_back(static_cast<uint32_t>(cell));
+        ++cell_starts_[cell + 1];
+    }
+    for (size_t i = 1; i < cell_starts_.size(); ++i) {
+        cell_starts_[i] += cell_starts_[i - 1];
+    }
+
+    std::vector<uint32_t> next(cell_starts_.begin(), cell_starts_.end() - 1);
+    points_.resize(points.size());
+    stops_.resize(points.size());
+    for (StopId id = 0; id < points.size(); ++id) {
+        const uint32_t position = next[cell_of_stop[id]]++;
+        points_[position] = points[id];
+        stops_[position] = catalogue.GetStopById(id);
+    }
+}
+
+size_t StopIndex::Size() const {
+    return stops_.size();
+}
+
+size_t StopIndex::CellRow(double lat) const {
+    if (!(lat > min_lat_)) {
+        return 0;
+    }
+    return std::min(static_cast<size_t>((lat - min_lat_) / cell_lat_), rows_ - 1);
+}
+
+size_t StopIndex::CellColumn(double lng) const {
+    if (!(lng > min_lng_)) {
+        return 0;
+    }
+    return std::min(static_cast<size_t>((lng - min_lng_) / cell_lng_), columns_ - 1);
+}
+
+double StopIndex::GapDistance(geo::Coordinates point, size_t gap) const {
+    if (gap == 0) {
+        return 0;
+    }
+    const double lat_distance = gap * cell_lat_ * METERS_PER_DEGREE;
+    // По формуле гаверсинусов разница долгот dl даёт не меньше
+    // 2R * asin(cos(L) * sin(dl / 2)), где L — наибольшая по модулю широта
+    const double max_lat = std::min(std::max(std::abs(point.lat), max_abs_lat_), 90.0) * DEG_TO_RAD;
+    const double lng_angle = std::min(gap * cell_lng_ * DEG_TO_RAD, M_PI);
+    const double lng_distance = 2 * geo::RADIUS_OF_EATH
+        * std::asin(std::min(1.0, std::cos(max_lat) * std::sin(lng_angle / 2)));
+    return std::min(lat_distance, lng_distance);
+}
+
+template <typename Visitor>
+void StopIndex::VisitCell(size_t row, size_t column, geo::Coordinates point, Visitor& visit) const {
+    const size_t cell = row * columns_ + column;
+    for (size_t i = cell_starts_[cell]; i < cell_starts_[cell + 1]; ++i) {
+        visit(stops_[i], geo::ComputeDistance(point, points_[i]));
+    }
+}
+
+std::vector<NearbyStop> StopIndex::NearestStops(geo::Coordinates point, size_t count) const {
+    std::vector<NearbyStop> best;
+    count = std::min(count, stops_.size());
+    if (count == 0) {
+        return best;
+    }
+    best.reserve(count);
+
+    // best — куча с самой дальней из найденных остановок на вершине
+    auto visit = [&best, count](const Stop* stop, double distance) {
+        const NearbyStop candidate{stop, distance};
+        if (best.size() < count) {
+            best.push_back(candidate);
+            std::push_heap(best.begin(), best.end(), IsCloser);
+        } else if (IsCloser(candidate, best.front())) {
+            std::pop_heap(best.begin(), best.end(), IsCloser);
+            best.back() = candidate;
+            std::push_heap(best.begin(), best.end(), IsCloser);
+        }
+    };
+
+    // Обход колец ячеек вокруг точки, пока следующее кольцо может дать остановку ближе найденных
+    const size_t row = CellRow(point.lat);
+    const size_t column = CellColumn(point.lng);
+    const size_t max_ring = std::max({row, rows_ - 1 - row, column, columns_ - 1 - column});
+    for (size_t ring = 0; ring <= max_ring; ++ring) {
+        if (best.size() == count && ring > 0 && GapDistance(point, ring - 1) > best.front().distance) {
+            break;
+        }
+        const size_t first_row = row >= ring ? row - ring : 0;
+        const size_t last_row = std::min(row + ring, rows_ - 1);
+        const size_t first_column = column >= ring ? column - ring : 0;
+        const size_t last_column = std::min(column + ring, columns_ - 1);
+        for (size_t r = first_row; r <= last_row; ++r) {
+            if (r + ring == row || r == row + ring) {
+                for (size_t c = first_column; c <= last_column; ++c) {
+                    VisitCell(r, c, point, visit);
+                }
+            } else {
+                if (column >= ring) {
+                    VisitCell(r, column - ring, point, visit);
+                }
+                if (column + ring < columns_) {
+                    VisitCell(r, column + ring, point, visit);
+                }
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end(), IsCloser);
+    return best;
+}
+
+std::vector<NearbyStop> StopIndex::StopsInRadius(geo::Coordinates point, double meters) const {
+    std::vector<NearbyStop> result;
+    if (stops_.empty() || !(meters >= 0)) {
+        return result;
+    }
+
+    // Прямоугольник широт и долгот, в который гарантированно попадает круг
+    const double angle = std::min(meters / geo::RADIUS_OF_EATH, M_PI);
+    const double lat_delta = angle / DEG_TO_RAD * (1 + 1e-9);
+    const double max_lat_cos = std::cos(std::min(std::abs(point.lat) + lat_delta, 90.0) * DEG_TO_RAD);
+    const double lng_sin = max_lat_cos > 0 ? std::sin(angle / 2) / max_lat_cos : 2;
+    const double lng_delta = lng_sin < 1 ? 2 * std::asin(lng_sin) / DEG_TO_RAD * (1 + 1e-9) : 360;
+
+    auto visit = [&result, meters](const Stop* stop, double distance) {
+        if (distance <= meters) {
+            result.push_back({stop, distance});
+        }
+    };
+    const size_t last_row = CellRow(point.lat + lat_delta);
+    const size_t last_column = CellColumn(point.lng + lng_delta);
+    for (size_t row = CellRow(point.lat - lat_delta); row <= last_row; ++row) {
+        for (size_t column = CellColumn(point.lng - lng_delta); column <= last_column; ++column) {
+            VisitCell(row, column, point, visit);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), IsCloser);
+    return result;
+}
+
+} // namespace transport
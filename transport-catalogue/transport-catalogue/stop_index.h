@@ -0,0 +1,53 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace transport {
+
+struct NearbyStop {
+    const Stop* stop;
+    // Метры, как считает geo::ComputeDistance
+    double distance;
+};
+
+// Пространственный индекс остановок: равномерная сетка по широте и долготе,
+// около двух остановок на ячейку. Строится по заполненному справочнику
+// и после этого не меняется, поэтому запросы можно делать из разных потоков.
+// Переход через 180-й меридиан не поддерживается.
+class StopIndex {
+public:
+    explicit StopIndex(const TransportCatalogue& catalogue);
+
+    // count ближайших остановок, по возрастанию расстояния
+    std::vector<NearbyStop> NearestStops(geo::Coordinates point, size_t count) const;
+    // Остановки не дальше meters, по возрастанию расстояния
+    std::vector<NearbyStop> StopsInRadius(geo::Coordinates point, double meters) const;
+
+    size_t Size() const;
+
+private:
+    size_t CellRow(double lat) const;
+    size_t CellColumn(double lng) const;
+    // Нижняя граница расстояния до точки, отстоящей от point на gap целых ячеек
+    double GapDistance(geo::Coordinates point, size_t gap) const;
+    template <typename Visitor>
+    void VisitCell(size_t row, size_t column, geo::Coordinates point, Visitor& visit) const;
+
+    double min_lat_ = 0;
+    double min_lng_ = 0;
+    double cell_lat_ = 1;
+    double cell_lng_ = 1;
+    double max_abs_lat_ = 0;
+    size_t rows_ = 1;
+    size_t columns_ = 1;
+
+    // Остановки ячейки i лежат в points_ и stops_ на [cell_starts_[i], cell_starts_[i + 1])
+    std::vector<uint32_t> cell_starts_;
+    std::vector<geo::Coordinates> points_;
+    std::vector<const Stop*> stops_;
+};
+
+} // namespace transport
@@ -0,0 +1,203 @@
+#include "stop_search.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace transport {
+
+namespace {
+
+bool StartsWith(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// Кодовая точка UTF-8 в начале text и её длина в байтах.
+// Некорректная последовательность читается как один байт
+std::pair<char32_t, size_t> DecodeUtf8(std::string_view text) {
+    const auto lead = static_cast<unsigned char>(text[0]);
+    size_t length = 1;
+    char32_t code = lead;
+    if (lead >= 0xF0) {
+        length = 4;
+        code = lead & 0x07;
+    } else if (lead >= 0xE0) {
+        length = 3;
+        code = lead & 0x0F;
+    } else if (lead >= 0xC0) {
+        length = 2;
+        code = lead & 0x1F;
+    }
+    if (length > text.size()) {
+        return {lead, 1};
+    }
+    for (size_t i = 1; i < length; ++i) {
+        const auto next = static_cast<unsigned char>(text[i]);
+        if ((next & 0xC0) != 0x80) {
+            return {lead, 1};
+        }
+        code = (code << 6) | (next & 0x3F);
+    }
+    return {code, length};
+}
+
+std::vector<char32_t> DecodeUtf8String(std::string_view text) {
+    std::vector<char32_t> result;
+    while (!text.empty()) {
+        const auto [code, length] = DecodeUtf8(text);
+        result.push_back(code);
+        text.remove_prefix(length);
+    }
+    return result;
+}
+
+size_t CommonPrefixLength(std::string_view lhs, std::string_view rhs) {
+    const size_t size = std::min(lhs.size(), rhs.size());
+    size_t i = 0;
+    while (i < size && lhs[i] == rhs[i]) {
+        ++i;
+    }
+    return i;
+}
+
+}
+
+StopNameIndex::StopNameIndex(const TransportCatalogue& catalogue) {
+    // Имена из пула справочника рядом с указателем, чтобы сортировка не ходила в остановки
+    const size_t count = catalogue.GetAllStops().size();
+    std::vector<std::pair<std::string_view, const Stop*>> sorted;
+    sorted.reserve(count);
+    size_t total_size = 0;
+    for (StopId id = 0; id < count; ++id) {
+        const std::string_view name = catalogue.GetStopName(id);
+        sorted.emplace_back(name, catalogue.GetStopById(id));
+        total_size += name.size();
+    }
+    if (total_size > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("StopNameIndex: names are too long");
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    names_.reserve(total_size);
+    starts_.reserve(sorted.size() + 1);
+    stops_.reserve(sorted.size());
+    for (const auto& [name, stop] : sorted) {
+        starts_.push_back(static_cast<uint32_t>(names_.size()));
+        names_ += name;
+        stops_.push_back(stop);
+    }
+    starts_.push_back(static_cast<uint32_t>(names_.size()));
+}
+
+std::vector<const Stop*> StopNameIndex::FindByPrefix(std::string_view prefix, size_t limit) const {
+    std::vector<const Stop*> result;
+    size_t first = 0;
+    size_t count = stops_.size();
+    while (count > 0) {
+        const size_t step = count / 2;
+        if (Name(first + step) < prefix) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    for (size_t i = first; i < stops_.size() && result.size() < limit && StartsWith(Name(i), prefix); ++i) {
+        result.push_back(stops_[i]);
+    }
+    return result;
+}
+
+std::vector<StopMatch> StopNameIndex::FindSimilar(std::string_view query, int max_edits, size_t limit) const {
+    max_edits = std::clamp(max_edits, 0, MAX_EDITS);
+    const std::vector<char32_t> pattern = DecodeUtf8String(query);
+    const size_t width = pattern.size() + 1;
+
+    // Обход сортированных имён как бора: строка d таблицы Левенштейна относится
+    // к первым d кодовым точкам текущего имени и переиспользуется для следующего
+    // имени с тем же префиксом. Глубже pattern.size() + max_edits + 1
+    // строка не бывает: её минимум не меньше глубины минус длина запроса
+    std::vector<int> rows(width * (pattern.size() + max_edits + 2));
+    for (size_t j = 0; j < width; ++j) {
+        rows[j] = static_cast<int>(j);
+    }
+    // depth_bytes[d] — длина в байтах первых d кодовых точек предыдущего имени
+    std::vector<size_t> depth_bytes = {0};
+    std::string_view previous;
+
+    std::vector<StopMatch> result;
+    size_t i = 0;
+    while (i < stops_.size()) {
+        const std::string_view name = Name(i);
+        const size_t common = CommonPrefixLength(previous, name);
+        while (depth_bytes.back() > common) {
+            depth_bytes.pop_back();
+        }
+        previous = name;
+
+        bool pruned = false;
+        size_t position = depth_bytes.back();
+        while (position < name.size()) {
+            const auto [code, length] = DecodeUtf8(name.substr(position));
+            const size_t depth = depth_bytes.size();
+            const int* above = &rows[(depth - 1) * width];
+            int* row = &rows[depth * width];
+            row[0] = static_cast<int>(depth);
+            int row_min = row[0];
+            for (size_t j = 1; j < width; ++j) {
+                row[j] = std::min({above[j] + 1, row[j - 1] + 1, above[j - 1] + (pattern[j - 1] != code)});
+                row_min = std::min(row_min, row[j]);
+            }
+            position += length;
+            depth_bytes.push_back(position);
+            if (row_min > max_edits) {
+                // Ни одно имя с этим префиксом не подойдёт
+                i = SkipPrefix(i, name.substr(0, position));
+                pruned = true;
+                break;
+            }
+        }
+        if (pruned) {
+            continue;
+        }
+        const int edits = rows[(depth_bytes.size() - 1) * width + pattern.size()];
+        if (edits <= max_edits) {
+            result.push_back({stops_[i], edits});
+        }
+        ++i;
+    }
+
+    // Имена уже по алфавиту, стабильная сортировка сохраняет этот порядок
+    std::stable_sort(result.begin(), result.end(), [](const StopMatch& lhs, const StopMatch& rhs) {
+        return lhs.edits < rhs.edits;
+    });
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+size_t StopNameIndex::Size() const {
+    return stops_.size();
+}
+
+std::string_view StopNameIndex::Name(size_t index) const {
+    return std::string_view(names_).substr(starts_[index], starts_[index + 1] - starts_[index]);
+}
+
+size_t StopNameIndex::SkipPrefix(size_t from, std::string_view prefix) const {
+    size_t first = from + 1;
+    size_t count = stops_.size() - first;
+    while (count > 0) {
+        const size_t step = count / 2;
+        if (StartsWith(Name(first + step), prefix)) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+} // namespace transport
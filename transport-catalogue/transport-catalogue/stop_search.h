@@ -0,0 +1,47 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+struct StopMatch {
+    const Stop* stop;
+    // Расстояние Левенштейна по кодовым точкам UTF-8
+    int edits;
+};
+
+// Индекс имён остановок для автодополнения и поиска с опечатками:
+// имена отсортированы и лежат подряд в одной строке.
+// Строится по заполненному справочнику и после этого не меняется.
+class StopNameIndex {
+public:
+    // Больше правок поиск с опечатками не допускает: дальше совпадает почти всё
+    static constexpr int MAX_EDITS = 3;
+
+    explicit StopNameIndex(const TransportCatalogue& catalogue);
+
+    // Не больше limit остановок, чьё имя начинается с prefix, по алфавиту
+    std::vector<const Stop*> FindByPrefix(std::string_view prefix, size_t limit) const;
+    // Не больше limit остановок не дальше max_edits правок от query,
+    // по возрастанию числа правок, при равенстве по алфавиту
+    std::vector<StopMatch> FindSimilar(std::string_view query, int max_edits, size_t limit) const;
+
+    size_t Size() const;
+
+private:
+    std::string_view Name(size_t index) const;
+    // Первый индекс после from, имя которого не начинается с prefix
+    size_t SkipPrefix(size_t from, std::string_view prefix) const;
+
+    // Имя i — names_[starts_[i], starts_[i + 1])
+    std::string names_;
+    std::vector<uint32_t> starts_;
+    std::vector<const Stop*> stops_;
+};
+
+} // namespace transport
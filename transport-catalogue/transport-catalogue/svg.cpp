@@ -24,7 +24,9 @@ namespace svg {
             out << "rgba("sv << static_cast<int>(rgba.red)  //
                 << ',' << static_cast<int>(rgba.green)      //
                 << ',' << static_cast<int>(rgba.blue)       //
-                << ',' << rgba.opacity << ')';
+                << ',';
+            output::WriteNumber(out, rgba.opacity);
+            out << ')';
         }
 
     }  
@@ -96,8 +98,13 @@ namespace svg {
 
     void Circle::RenderObject(const RenderContext& context) const {
         auto& out = context.out;
-        out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-        out << "r=\""sv << radius_ << "\" "sv;
+        out << "<circle cx=\""sv;
+        output::WriteNumber(out, center_.x);
+        out << "\" cy=\""sv;
+        output::WriteNumber(out, center_.y);
+        out << "\" r=\""sv;
+        output::WriteNumber(out, radius_);
+        out << "\" "sv;
         RenderAttrs(out);
         out << "/>"sv;
     }
@@ -118,7 +125,9 @@ namespace svg {
             else {
                 out << ' ';
             }
-            out << p.x << ',' << p.y;
+            output::WriteNumber(out, p.x);
+            out.put(',');
+            output::WriteNumber(out, p.y);
         }
         out << "\" "sv;
         RenderAttrs(out);
@@ -181,13 +190,29 @@ namespace svg {
     }
 
     void Document::Render(std::ostream& out) const {
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
-        RenderContext ctx{ out, 2, 2 };
+        StreamDocument stream(out);
         for (const auto& obj : objects_) {
-            obj->Render(ctx);
+            stream.Add(*obj);
         }
-        out << "</svg>"sv;
+        stream.Finish();
+    }
+
+    StreamFragment::StreamFragment(std::ostream& out)
+        : context_(out, 2, 2) {
+    }
+
+    void StreamFragment::AddPtr(std::unique_ptr<Object>&& obj) {
+        obj->Render(context_);
+    }
+
+    StreamDocument::StreamDocument(std::ostream& out)
+        : StreamFragment(out) {
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
+        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+    }
+
+    void StreamDocument::Finish() {
+        context_.out << "</svg>"sv;
     }
 
     namespace detail {
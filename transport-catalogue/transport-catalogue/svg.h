@@ -1,5 +1,7 @@
 #pragma once
 
+#include "output_buffer.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -25,6 +27,11 @@ namespace svg {
             HtmlEncodeString(out, s);
         }
 
+        template <>
+        inline void RenderValue<double>(std::ostream& out, const double& value) {
+            output::WriteNumber(out, value);
+        }
+
         template <typename AttrType>
         inline void RenderAttr(std::ostream& out, std::string_view name, const AttrType& value) {
             using namespace std::literals;
@@ -188,7 +195,7 @@ namespace svg {
         std::optional<StrokeLineJoin> stroke_line_join_;
     };
 
-    class Circle : public Object, public PathProps<Circle> {
+    class Circle final : public Object, public PathProps<Circle> {
     public:
         Circle& SetCenter(Point center);
         Circle& SetRadius(double radius);
@@ -200,7 +207,7 @@ namespace svg {
         double radius_ = 1.0;
     };
 
-    class Polyline : public Object, public PathProps<Polyline> {
+    class Polyline final : public Object, public PathProps<Polyline> {
     public:
         Polyline& AddPoint(Point point);
 
@@ -209,7 +216,7 @@ namespace svg {
         std::vector<Point> points_;
     };
 
-    class Text : public Object, public PathProps<Text> {
+    class Text final : public Object, public PathProps<Text> {
     public:
         Text& SetPosition(Point pos);
         Text& SetOffset(Point offset);
@@ -257,4 +264,31 @@ namespace svg {
         std::vector<std::unique_ptr<Object>> objects_;
     };
 
+    // Последовательность элементов без заголовка svg: каждый объект сразу
+    // выводится в поток, поэтому не нужны ни куча, ни unique_ptr на элемент.
+    // Фрагменты, отрисованные отдельно, можно склеить в один документ
+    class StreamFragment : public ObjectContainer {
+    public:
+        explicit StreamFragment(std::ostream& out);
+
+        template <typename ObjectType>
+        void Add(const ObjectType& object) {
+            object.Render(context_);
+        }
+
+        void AddPtr(std::unique_ptr<Object>&& obj) override;
+
+    protected:
+        RenderContext context_;
+    };
+
+    // Фрагмент с заголовком svg
+    class StreamDocument final : public StreamFragment {
+    public:
+        explicit StreamDocument(std::ostream& out);
+
+        // Закрывает тег svg, после этого добавлять объекты нельзя
+        void Finish();
+    };
+
 }  
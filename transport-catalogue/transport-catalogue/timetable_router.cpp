@@ -0,0 +1,137 @@
+#include "timetable_router.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace transport {
+
+namespace {
+    constexpr double MINUTES_IN_HOUR = 60.0;
+    constexpr double METERS_IN_KILOMETER = 1000.0;
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    constexpr size_t NONE = std::numeric_limits<size_t>::max();
+}
+
+TimetableRouter::TimetableRouter(const TransportCatalogue& catalogue, const RoutingSettings& settings)
+    : catalogue_(catalogue), settings_(settings) {
+    BuildConnections();
+}
+
+double TimetableRouter::ComputeBusTime(int distance) const {
+    return (distance * MINUTES_IN_HOUR) / (settings_.bus_velocity * METERS_IN_KILOMETER);
+}
+
+void TimetableRouter::BuildConnections() {
+    for (const auto& bus : catalogue_.GetAllBuses()) {
+        if (catalogue_.GetRoute(bus.GetId()).size() < 2) {
+            continue;
+        }
+        for (double departure : catalogue_.GetBusDepartures(&bus)) {
+            AddTrip(bus, departure);
+        }
+    }
+
+    std::stable_sort(connections_.begin(), connections_.end(),
+        [](const Connection& lhs, const Connection& rhs) {
+            return lhs.departure < rhs.departure;
+        });
+}
+
+void TimetableRouter::AddTrip(const Bus& bus, double departure) {
+    const size_t trip = trips_.size();
+    trips_.push_back({&bus});
+
+    const auto stops = catalogue_.GetRoute(bus.GetId());
+    double time = departure;
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        const int distance = catalogue_.GetStopDistance(catalogue_.GetStopById(stops[i]), catalogue_.GetStopById(stops[i + 1]));
+        const double arrival = time + ComputeBusTime(distance);
+        connections_.push_back({
+            stops[i],
+            stops[i + 1],
+            time,
+            arrival,
+            trip,
+            i
+        });
+        time = arrival;
+    }
+}
+
+std::optional<RouteInfo> TimetableRouter::FindRoute(std::string_view from, std::string_view to, double departure_time) const {
+    const Stop* from_stop = catalogue_.GetStop(from);
+    const Stop* to_stop = catalogue_.GetStop(to);
+    if (!from_stop || !to_stop) {
+        return std::nullopt;
+    }
+    const size_t source = from_stop->id_;
+    const size_t target = to_stop->id_;
+
+    RouteInfo result;
+    result.total_time = 0;
+    if (source == target) {
+        return result;
+    }
+
+    const size_t stop_count = catalogue_.GetAllStops().size();
+    std::vector<double> earliest_arrival(stop_count, INF);
+    std::vector<size_t> in_connection(stop_count, NONE);
+    std::vector<size_t> boarded_at(trips_.size(), NONE);
+    earliest_arrival[source] = departure_time;
+
+    auto first = std::lower_bound(connections_.begin(), connections_.end(), departure_time,
+        [](const Connection& conn, double time) {
+            return conn.departure < time;
+        });
+
+    for (size_t i = first - connections_.begin(); i < connections_.size(); ++i) {
+        const Connection& conn = connections_[i];
+        if (earliest_arrival[target] <= conn.departure) {
+            break;
+        }
+        if (boarded_at[conn.trip] == NONE) {
+            if (earliest_arrival[conn.from_stop] > conn.departure) {
+                continue;
+            }
+            boarded_at[conn.trip] = i;
+        }
+        if (conn.arrival < earliest_arrival[conn.to_stop]) {
+            earliest_arrival[conn.to_stop] = conn.arrival;
+            in_connection[conn.to_stop] = i;
+        }
+    }
+
+    if (in_connection[target] == NONE) {
+        return std::nullopt;
+    }
+
+    // Восстанавливаем поездки от конца к началу: пары (посадка, высадка)
+    std::vector<std::pair<const Connection*, const Connection*>> legs;
+    for (size_t stop = target; stop != source;) {
+        const Connection& alight = connections_[in_connection[stop]];
+        const Connection& board = connections_[boarded_at[alight.trip]];
+        legs.emplace_back(&board, &alight);
+        stop = board.from_stop;
+    }
+
+    result.items.reserve(legs.size() * 2);
+    double time = departure_time;
+    for (auto it = legs.rbegin(); it != legs.rend(); ++it) {
+        const auto [board, alight] = *it;
+        result.items.push_back(RouteInfo::WaitItem{
+            catalogue_.GetStopById(static_cast<StopId>(board->from_stop)),
+            board->departure - time
+        });
+        result.items.push_back(RouteInfo::BusItem{
+            trips_[board->trip].bus,
+            static_cast<int>(alight->stop_pos - board->stop_pos + 1),
+            alight->arrival - board->departure
+        });
+        time = alight->arrival;
+    }
+    result.total_time = earliest_arrival[target] - departure_time;
+
+    return result;
+}
+
+} // namespace transport
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+// Маршрутизация по расписанию: Connection Scan Algorithm поверх
+// отсортированного по времени отправления массива перегонов.
+// Как и TransportRouter, снимок справочника на момент построения
+class TimetableRouter {
+public:
+    TimetableRouter(const TransportCatalogue& catalogue, const RoutingSettings& settings);
+
+    TimetableRouter(const TimetableRouter&) = delete;
+    TimetableRouter& operator=(const TimetableRouter&) = delete;
+
+    // departure_time и время в ответе — в минутах от начала суток
+    std::optional<RouteInfo> FindRoute(std::string_view from, std::string_view to, double departure_time) const;
+
+private:
+    // Остановки — StopId справочника
+    struct Connection {
+        size_t from_stop;
+        size_t to_stop;
+        double departure;
+        double arrival;
+        size_t trip;
+        size_t stop_pos;    // номер перегона внутри рейса
+    };
+
+    struct Trip {
+        const Bus* bus;
+    };
+
+    void BuildConnections();
+    void AddTrip(const Bus& bus, double departure);
+
+    double ComputeBusTime(int distance) const;
+
+    const TransportCatalogue& catalogue_;
+    const RoutingSettings settings_;
+
+    std::vector<Trip> trips_;
+    std::vector<Connection> connections_;
+};
+
+} // namespace transport
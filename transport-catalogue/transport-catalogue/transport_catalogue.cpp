@@ -5,26 +5,87 @@
 
 using namespace transport;
 
-void TransportCatalogue::AddBus(const Bus& bus) {
-    buses_.push_back(bus);
+void TransportCatalogue::AddBus(std::string name, const std::vector<const Stop*>& stops, Type type) {
+    ++version_;
+    buses_.emplace_back(std::move(name), type);
+    buses_.back().id_ = static_cast<BusId>(buses_.size() - 1);
+    routes_.push_back({0, 0});
+    AppendRoute(buses_.back().id_, stops);
+    frozen_buses_.reset();
     auto [it, inserted] = bus_ptrs_.emplace(buses_.back().name_, &buses_.back());
     const Bus* added_bus = it->second;
-    for (const Stop* stop : added_bus->GetStops()) {
+    bus_versions_[&buses_.back()] = version_;
+    for (const Stop* stop : stops) {
         buses_by_stop_[stop].insert(added_bus);
     }
 }
 
-void TransportCatalogue::AddStop(const Stop& stop) {
-    stops_.push_back(stop);
+std::string_view NamePool::Add(std::string_view name) {
+    if (capacity_ - used_ < name.size()) {
+        // Длинное имя получает собственный блок
+        capacity_ = std::max(BLOCK_SIZE, name.size());
+        blocks_.push_back(std::make_unique<char[]>(capacity_));
+        used_ = 0;
+    }
+    char* data = blocks_.empty() ? nullptr : blocks_.back().get() + used_;
+    std::copy(name.begin(), name.end(), data);
+    used_ += name.size();
+    return std::string_view(data, name.size());
+}
+
+void TransportCatalogue::AddStop(std::string name, geo::Coordinates coordinates) {
+    ++version_;
+    stops_.emplace_back(stop_names_.Add(name));
+    stops_.back().id_ = static_cast<StopId>(stops_.size() - 1);
+    stop_coordinates_.push_back(coordinates);
+    frozen_stops_.reset();
     stop_ptrs_.emplace(stops_.back().name_, &stops_.back());
+    stop_versions_[&stops_.back()] = version_;
+}
+
+void TransportCatalogue::UpdateBus(std::string name, const std::vector<const Stop*>& stops, Type type) {
+    auto pos = bus_ptrs_.find(name);
+    if (pos == bus_ptrs_.end()) {
+        AddBus(std::move(name), stops, type);
+        return;
+    }
+
+    ++version_;
+    Bus& existing = *pos->second;
+    for (StopId stop : GetForwardRoute(existing.id_)) {
+        buses_by_stop_[&stops_[stop]].erase(&existing);
+    }
+    existing.type_ = type;
+    stale_route_stops_ += routes_[existing.id_].length;
+    AppendRoute(existing.id_, stops);
+    if (stale_route_stops_ > route_stops_.size() / 2) {
+        CompactRoutes();
+    }
+    for (const Stop* stop : stops) {
+        buses_by_stop_[stop].insert(&existing);
+    }
+    bus_versions_[&existing] = version_;
+}
+
+void TransportCatalogue::FreezeNames() {
+    frozen_buses_.emplace(std::vector<std::pair<std::string_view, Bus*>>(bus_ptrs_.begin(), bus_ptrs_.end()));
+    frozen_stops_.emplace(std::vector<std::pair<std::string_view, const Stop*>>(stop_ptrs_.begin(), stop_ptrs_.end()));
 }
 
 const Bus* TransportCatalogue::GetBus(std::string_view name) const {
+    if (frozen_buses_) {
+        auto found = frozen_buses_->Find(name);
+        return found ? *found : nullptr;
+    }
     auto pos = bus_ptrs_.find(name);
     return pos == bus_ptrs_.end() ? nullptr : pos->second;
 }
 
 const Stop* TransportCatalogue::GetStop(std::string_view name) const {
+    if (frozen_stops_) {
+        auto found = frozen_stops_->Find(name);
+        return found ? *found : nullptr;
+    }
     auto pos = stop_ptrs_.find(name);
     return pos == stop_ptrs_.end() ? nullptr : pos->second;
 }
@@ -42,6 +103,7 @@ const Stop* TransportCatalogue::GetStopPtrByName(std::string_view name) const {
 }
 
 void TransportCatalogue::SetStopDistance(const Stop* from, const Stop* to, int distance) {
+    ++version_;
     distances_[{from, to}] = distance;
 }
 
@@ -64,6 +126,17 @@ int TransportCatalogue::GetStopDistance(std::string_view from, std::string_view
     return GetStopDistance(GetStop(from), GetStop(to));
 }
 
+void TransportCatalogue::SetBusDepartures(const Bus* bus, std::vector<double> departures) {
+    ++version_;
+    std::sort(departures.begin(), departures.end());
+    departures_[bus] = std::move(departures);
+}
+
+const std::vector<double>& TransportCatalogue::GetBusDepartures(const Bus* bus) const {
+    auto pos = departures_.find(bus);
+    return pos != departures_.end() ? pos->second : empty_departures_;
+}
+
 const std::deque<Bus>& TransportCatalogue::GetAllBuses() const {
     return buses_;
 }
@@ -71,3 +144,58 @@ const std::deque<Bus>& TransportCatalogue::GetAllBuses() const {
 const std::deque<Stop>& TransportCatalogue::GetAllStops() const {
     return stops_;
 }
+
+const std::vector<geo::Coordinates>& TransportCatalogue::GetStopCoordinates() const {
+    return stop_coordinates_;
+}
+
+std::string_view TransportCatalogue::GetStopName(StopId id) const {
+    return stops_[id].name_;
+}
+
+const Stop* TransportCatalogue::GetStopById(StopId id) const {
+    return &stops_[id];
+}
+
+RouteTraversal<StopId> TransportCatalogue::GetRoute(BusId id) const {
+    const RouteSlice& slice = routes_[id];
+    return RouteTraversal<StopId>(route_stops_.data() + slice.offset, slice.length, buses_[id].is_round());
+}
+
+RouteView TransportCatalogue::GetForwardRoute(BusId id) const {
+    const RouteSlice& slice = routes_[id];
+    return RouteView(route_stops_.data() + slice.offset, slice.length);
+}
+
+void TransportCatalogue::AppendRoute(BusId id, const std::vector<const Stop*>& stops) {
+    routes_[id] = {static_cast<uint32_t>(route_stops_.size()), static_cast<uint32_t>(stops.size())};
+    for (const Stop* stop : stops) {
+        route_stops_.push_back(stop->id_);
+    }
+}
+
+void TransportCatalogue::CompactRoutes() {
+    std::vector<StopId> compacted;
+    compacted.reserve(route_stops_.size() - stale_route_stops_);
+    for (RouteSlice& slice : routes_) {
+        const auto first = route_stops_.begin() + slice.offset;
+        slice.offset = static_cast<uint32_t>(compacted.size());
+        compacted.insert(compacted.end(), first, first + slice.length);
+    }
+    route_stops_ = std::move(compacted);
+    stale_route_stops_ = 0;
+}
+
+size_t TransportCatalogue::GetVersion() const {
+    return version_;
+}
+
+size_t TransportCatalogue::GetBusVersion(const Bus* bus) const {
+    auto pos = bus_versions_.find(bus);
+    return pos != bus_versions_.end() ? pos->second : 0;
+}
+
+size_t TransportCatalogue::GetStopVersion(const Stop* stop) const {
+    auto pos = stop_versions_.find(stop);
+    return pos != stop_versions_.end() ? pos->second : 0;
+}
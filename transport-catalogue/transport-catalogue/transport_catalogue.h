@@ -1,18 +1,60 @@
 #pragma once
 
 #include "domain.h"
+#include "perfect_hash.h"
 
 #include <unordered_map>
 #include <deque>
 #include <set>
 #include <functional>
+#include <memory>
+#include <optional>
 
 namespace transport {
 
+// Сохранённые остановки маршрута (прямое направление) в общем массиве маршрутов
+// справочника. Действителен до следующего добавления или изменения автобуса
+class RouteView {
+public:
+    RouteView(const StopId* data, size_t size) : data_(data), size_(size) {}
+
+    const StopId* begin() const { return data_; }
+    const StopId* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    StopId operator[](size_t index) const { return data_[index]; }
+
+private:
+    const StopId* data_;
+    size_t size_;
+};
+
+// Имена подряд в больших блоках, которые никогда не перемещаются, поэтому
+// string_view на них верны, пока жив пул
+class NamePool {
+public:
+    std::string_view Add(std::string_view name);
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t used_ = 0;
+    size_t capacity_ = 0;
+};
+
 class TransportCatalogue {
 public:
-    void AddBus(const Bus& bus);
-    void AddStop(const Stop& stop);
+    // stops — только прямое направление, обратное для некольцевого маршрута не хранится
+    void AddBus(std::string name, const std::vector<const Stop*>& stops, Type type);
+    void AddStop(std::string name, geo::Coordinates coordinates);
+    // Заменяет маршрут автобуса с тем же именем, указатель на автобус не меняется.
+    // Если такого автобуса нет, добавляет его
+    void UpdateBus(std::string name, const std::vector<const Stop*>& stops, Type type);
+
+    // Замораживает таблицы имён: GetStop и GetBus идут через совершенный хеш.
+    // Добавление остановки или автобуса снимает заморозку
+    void FreezeNames();
 
     const Bus* GetBus(std::string_view name) const;
     const Stop* GetStop(std::string_view name) const;
@@ -28,17 +70,58 @@ public:
     int GetStopDistance(std::string_view from, std::string_view to) const;
     int GetStopDistance(const Stop* from, const Stop* to) const;
 
+    void SetBusDepartures(const Bus* bus, std::vector<double> departures);
+    const std::vector<double>& GetBusDepartures(const Bus* bus) const;
+
     const std::deque<Bus>& GetAllBuses() const;
     const std::deque<Stop>& GetAllStops() const;
 
+    // Столбцы по StopId и BusId: координаты подряд, имена остановок в общем пуле,
+    // маршруты всех автобусов в одном массиве. Stop и Bus — стабильные ручки
+    // с именем и номером, остановки и маршруты в них не дублируются
+    const std::vector<geo::Coordinates>& GetStopCoordinates() const;
+    std::string_view GetStopName(StopId id) const;
+    const Stop* GetStopById(StopId id) const;
+    // Полный проход маршрута, для некольцевого — туда и обратно
+    RouteTraversal<StopId> GetRoute(BusId id) const;
+    RouteView GetForwardRoute(BusId id) const;
+
+    // Увеличивается при каждом изменении справочника
+    size_t GetVersion() const;
+    // Версия справочника, при которой автобус или остановка последний раз менялись
+    size_t GetBusVersion(const Bus* bus) const;
+    size_t GetStopVersion(const Stop* stop) const;
+
 private:
+    struct RouteSlice {
+        uint32_t offset;
+        uint32_t length;
+    };
+    void AppendRoute(BusId id, const std::vector<const Stop*>& stops);
+    // Убирает из route_stops_ маршруты, заменённые через UpdateBus
+    void CompactRoutes();
+
     std::deque<Bus> buses_;
     std::deque<Stop> stops_;
-    std::unordered_map<std::string_view, const Bus*> bus_ptrs_;
+    std::vector<geo::Coordinates> stop_coordinates_;
+    // Stop::name_ и ключи stop_ptrs_ указывают сюда
+    NamePool stop_names_;
+    std::vector<StopId> route_stops_;
+    std::vector<RouteSlice> routes_;
+    // Сколько элементов route_stops_ больше не принадлежат ни одному маршруту
+    size_t stale_route_stops_ = 0;
+    std::unordered_map<std::string_view, Bus*> bus_ptrs_;
     std::unordered_map<std::string_view, const Stop*> stop_ptrs_;
+    std::optional<FrozenNameTable<Bus*>> frozen_buses_;
+    std::optional<FrozenNameTable<const Stop*>> frozen_stops_;
     std::unordered_map<const Stop*, std::set<const Bus*, BusComparator>> buses_by_stop_;
     const std::set<const Bus*, BusComparator> empty_set_;
     std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistanceHasher> distances_;
+    std::unordered_map<const Bus*, std::vector<double>> departures_;
+    const std::vector<double> empty_departures_;
+    std::unordered_map<const Bus*, size_t> bus_versions_;
+    std::unordered_map<const Stop*, size_t> stop_versions_;
+    size_t version_ = 0;
 };
 
 } 
@@ -1,18 +1,79 @@
 #include "transport_router.h"
+#include "stats.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace transport {
 
 namespace { 
     constexpr double MINUTES_IN_HOUR = 60.0;
     constexpr double METERS_IN_KILOMETER = 1000.0;
+    constexpr uint32_t NO_LABEL = std::numeric_limits<uint32_t>::max();
+    constexpr graph::EdgeId NO_EDGE = std::numeric_limits<graph::EdgeId>::max();
+}
+
+int RouteInfo::GetTransferCount() const {
+    const auto rides = std::count_if(items.begin(), items.end(), [](const Item& item) {
+        return std::holds_alternative<BusItem>(item);
+    });
+    return rides > 0 ? static_cast<int>(rides) - 1 : 0;
+}
+
+RouteCache::RouteCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+std::optional<RouteCache::Value> RouteCache::Get(Key key) {
+    // Выключенный кэш не ведёт статистику, иначе в ней одни промахи
+    if (capacity_ == 0) {
+        return std::nullopt;
+    }
+    std::lock_guard lock(mutex_);
+    auto pos = positions_.find(key);
+    if (pos == positions_.end()) {
+        ++stats_.misses;
+        stats::Count("route_cache.misses");
+        return std::nullopt;
+    }
+    ++stats_.hits;
+    stats::Count("route_cache.hits");
+    entries_.splice(entries_.begin(), entries_, pos->second);
+    return pos->second->second;
+}
+
+void RouteCache::Put(Key key, Value value) {
+    if (capacity_ == 0) {
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    if (positions_.count(key)) {
+        return;
+    }
+    if (entries_.size() == capacity_) {
+        positions_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    positions_[key] = entries_.begin();
+}
+
+RouteCacheStats RouteCache::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
 }
 
 TransportRouter::TransportRouter(const TransportCatalogue& catalogue, const RoutingSettings& settings)
-    : catalogue_(catalogue), settings_(settings) {
-    BuildGraph();
+    : catalogue_(catalogue), settings_(settings), cache_(settings.route_cache_size) {
+    {
+        stats::ScopedTimer timer("router.build_graph");
+        BuildGraph();
+    }
+    stats::SetGauge("graph.vertices", graph_->GetVertexCount());
+    stats::SetGauge("graph.edges", graph_->GetEdgeCount());
+
+    stats::ScopedTimer timer("router.init");
     router_ = std::make_unique<graph::Router<double>>(*graph_);
 }
 
@@ -20,6 +81,10 @@ double TransportRouter::ComputeBusTime(int distance) const {
     return (distance * MINUTES_IN_HOUR) / (settings_.bus_velocity * METERS_IN_KILOMETER);
 }
 
+double TransportRouter::ComputeWalkTime(double distance) const {
+    return (distance * MINUTES_IN_HOUR) / (settings_.walking_velocity * METERS_IN_KILOMETER);
+}
+
 void TransportRouter::BuildGraph() {
     InitializeStopVertices();
     AddWaitEdges();
@@ -31,12 +96,13 @@ void TransportRouter::InitializeStopVertices() {
     const size_t vertex_count = stops.size() * 2;
     graph_ = std::make_unique<graph::DirectedWeightedGraph<double>>(vertex_count);
 
+    vertex_to_stop_.reserve(vertex_count);
     size_t vertex_id = 0;
     for (const auto& stop : stops) {
         stop_to_vertex_wait_[stop.name_] = vertex_id;
         stop_to_vertex_bus_[stop.name_] = vertex_id + 1;
-        vertex_to_stop_[vertex_id] = stop.name_;
-        vertex_to_stop_[vertex_id + 1] = stop.name_;
+        vertex_to_stop_.push_back(&stop);
+        vertex_to_stop_.push_back(&stop);
         vertex_id += 2;
     }
 }
@@ -50,11 +116,11 @@ void TransportRouter::AddWaitEdges() {
             bus_vertex,
             static_cast<double>(settings_.bus_wait_time)
         };
-        auto wait_edge_id = graph_->AddEdge(wait_edge);
-        edge_to_wait_item_[wait_edge_id] = RouteInfo::WaitItem{
-            std::string(stop_name),
+        graph_->AddEdge(wait_edge);
+        edge_items_.push_back(RouteInfo::WaitItem{
+            vertex_to_stop_[wait_vertex],
             static_cast<double>(settings_.bus_wait_time)
-        };
+        });
     }
 }
 
@@ -62,37 +128,30 @@ void TransportRouter::AddBusEdges() {
     const auto& buses = catalogue_.GetAllBuses();
     
     for (const auto& bus : buses) {
-        const auto& bus_stops = bus.GetStops();
+        const auto bus_stops = catalogue_.GetRoute(bus.GetId());
         if (bus_stops.empty()) continue;
         
-        AddBusEdgesForDirection(bus, bus_stops, true);
-        
-        if (!bus.is_round()) {
-            AddBusEdgesForDirection(bus, bus_stops, false);
-        }
+        AddBusEdgesForRoute(bus, bus_stops);
     }
 }
 
-void TransportRouter::AddBusEdgesForDirection(const Bus& bus, const std::vector<const Stop*>& stops, bool forward) {
+// Полный проход некольцевого маршрута — палиндром, поэтому проход в обратную
+// сторону дал бы те же рёбра, что и прямой
+void TransportRouter::AddBusEdgesForRoute(const Bus& bus, const RouteTraversal<StopId>& stops) {
     const size_t size = stops.size();
-    const size_t start = forward ? 0 : size - 1;
-    const size_t end = forward ? size : 0;
-    const int step = forward ? 1 : -1;
-
-    for (size_t i = start; forward ? (i < end) : (i > end); i += step) {
+    for (size_t i = 0; i < size; ++i) {
         int distance = 0;
-        for (size_t j = i + step; forward ? (j < end) : (j > end); j += step) {
-            distance += forward 
-                ? catalogue_.GetStopDistance(stops[j-1]->name_, stops[j]->name_)
-                : catalogue_.GetStopDistance(stops[j+1]->name_, stops[j]->name_);
-            AddBusEdge(bus, i, j, distance);
+        for (size_t j = i + 1; j < size; ++j) {
+            distance += catalogue_.GetStopDistance(catalogue_.GetStopById(stops[j-1]), catalogue_.GetStopById(stops[j]));
+            AddBusEdge(bus, stops, i, j, distance);
         }
     }
 }
 
-void TransportRouter::AddBusEdge(const Bus& bus, size_t from_idx, size_t to_idx, int distance) {
-    const Stop* from_stop = bus.GetStops()[from_idx];
-    const Stop* to_stop = bus.GetStops()[to_idx];
+void TransportRouter::AddBusEdge(const Bus& bus, const RouteTraversal<StopId>& stops,
+                                 size_t from_idx, size_t to_idx, int distance) {
+    const Stop* from_stop = catalogue_.GetStopById(stops[from_idx]);
+    const Stop* to_stop = catalogue_.GetStopById(stops[to_idx]);
     
     double time = ComputeBusTime(distance);
     int span_count = abs(static_cast<int>(to_idx) - static_cast<int>(from_idx));
@@ -103,12 +162,12 @@ void TransportRouter::AddBusEdge(const Bus& bus, size_t from_idx, size_t to_idx,
         time
     };
     
-    auto edge_id = graph_->AddEdge(edge);
-    edge_to_bus_item_[edge_id] = RouteInfo::BusItem{
-        bus.GetName(),
+    graph_->AddEdge(edge);
+    edge_items_.push_back(RouteInfo::BusItem{
+        &bus,
         span_count,
         time
-    };
+    });
 }
 
 std::optional<RouteInfo> TransportRouter::FindRoute(const std::string_view from, const std::string_view to) const {
@@ -120,40 +179,456 @@ std::optional<RouteInfo> TransportRouter::FindRoute(const std::string_view from,
 
     if (!router_) return std::nullopt;
 
-    auto route_info = router_->BuildRoute(from_it->second, to_it->second);
+    const RouteCache::Key key{from_it->second, to_it->second};
+    if (auto cached = cache_.Get(key)) {
+        return *cached;
+    }
+
+    auto result = BuildRouteInfo(from_it->second, to_it->second);
+    cache_.Put(key, result);
+    return result;
+}
+
+std::optional<RouteInfo> TransportRouter::FindRoute(geo::Coordinates from, geo::Coordinates to, const StopIndex& stops) const {
+    // Целиком пешком — только если точки не дальше max_walking_distance
+    std::optional<RouteInfo> walk;
+    double best_time = std::numeric_limits<double>::infinity();
+    if (const double distance = geo::ComputeDistance(from, to); distance <= settings_.max_walking_distance) {
+        walk.emplace();
+        walk->total_time = ComputeWalkTime(distance);
+        if (walk->total_time > 0) {
+            walk->items.push_back(RouteInfo::WalkItem{nullptr, nullptr, walk->total_time});
+        }
+        best_time = walk->total_time;
+    }
+
+    const auto sources = stops.StopsInRadius(from, settings_.max_walking_distance);
+    const auto targets = stops.StopsInRadius(to, settings_.max_walking_distance);
+    if (sources.empty() || targets.empty()) {
+        return walk;
+    }
+
+    // Дейкстра сразу из всех остановок у начальной точки. Пешие участки
+    // в граф не добавляются: начальные расстояния — время пешком до остановки,
+    // а время пешком от остановки у конечной точки прибавляется при проходе
+    // ребра автобуса в неё. Так маршрут через остановку без поездки или
+    // с поездкой обратно на ту же остановку не обходит ограничение на путь
+    // целиком пешком
+    auto lease = point_states_.Acquire(graph_->GetVertexCount());
+    PointSearchState& state = *lease;
+    state.heap.clear();
+    const unsigned search = ++state.search;
+    const auto by_distance = [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+    };
+    for (const auto& [stop, distance] : sources) {
+        const graph::VertexId vertex = stop_to_vertex_wait_.at(stop->name_);
+        const double time = ComputeWalkTime(distance);
+        state.reached[vertex] = search;
+        state.distance[vertex] = time;
+        state.prev_edge[vertex] = NO_EDGE;
+        state.origin[vertex] = vertex;
+        state.heap.emplace_back(time, vertex);
+    }
+    std::make_heap(state.heap.begin(), state.heap.end(), by_distance);
+
+    std::unordered_map<graph::VertexId, double> walk_to_target;
+    for (const auto& [stop, distance] : targets) {
+        walk_to_target.emplace(stop_to_vertex_wait_.at(stop->name_), ComputeWalkTime(distance));
+    }
+
+    std::optional<graph::EdgeId> best_edge;
+    double best_arrival = 0;
+    while (!state.heap.empty()) {
+        std::pop_heap(state.heap.begin(), state.heap.end(), by_distance);
+        const auto [distance, vertex] = state.heap.back();
+        state.heap.pop_back();
+
+        if (distance > state.distance[vertex]) {
+            continue;
+        }
+        if (distance >= best_time) {
+            break;
+        }
+
+        for (graph::EdgeId edge_id : graph_->GetIncidentEdges(vertex)) {
+            const auto& edge = graph_->GetEdge(edge_id);
+            const double candidate = distance + edge.weight;
+            if (std::holds_alternative<RouteInfo::BusItem>(edge_items_[edge_id]) && edge.to != state.origin[vertex]) {
+                if (auto it = walk_to_target.find(edge.to); it != walk_to_target.end() && candidate + it->second < best_time) {
+                    best_time = candidate + it->second;
+                    best_arrival = candidate;
+                    best_edge = edge_id;
+                }
+            }
+            if (state.reached[edge.to] != search || candidate < state.distance[edge.to]) {
+                state.reached[edge.to] = search;
+                state.distance[edge.to] = candidate;
+                state.prev_edge[edge.to] = edge_id;
+                state.origin[edge.to] = state.origin[vertex];
+                state.heap.emplace_back(candidate, edge.to);
+                std::push_heap(state.heap.begin(), state.heap.end(), by_distance);
+            }
+        }
+    }
+
+    if (!best_edge) {
+        return walk;
+    }
+
+    // Вершины до последнего ребра уже извлечены, их prev_edge окончательны
+    const graph::VertexId finish = graph_->GetEdge(*best_edge).to;
+    std::vector<graph::EdgeId> edges{*best_edge};
+    graph::VertexId start = graph_->GetEdge(*best_edge).from;
+    for (; state.prev_edge[start] != NO_EDGE; start = graph_->GetEdge(edges.back()).from) {
+        edges.push_back(state.prev_edge[start]);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    const double last_walk = walk_to_target.at(finish);
+    const RouteInfo ride = MakeRouteInfo(best_arrival - state.distance[start], edges);
+    RouteInfo result;
+    result.total_time = best_time;
+    result.items.reserve(ride.items.size() + 2);
+    if (state.distance[start] > 0) {
+        result.items.push_back(RouteInfo::WalkItem{nullptr, vertex_to_stop_[start], state.distance[start]});
+    }
+    result.items.insert(result.items.end(), ride.items.begin(), ride.items.end());
+    if (last_walk > 0) {
+        result.items.push_back(RouteInfo::WalkItem{vertex_to_stop_[finish], nullptr, last_walk});
+    }
+    return result;
+}
+
+RouteCacheStats TransportRouter::GetCacheStats() const {
+    return cache_.GetStats();
+}
+
+std::optional<RouteInfo> TransportRouter::BuildRouteInfo(graph::VertexId from, graph::VertexId to) const {
+    auto route_info = router_->BuildRoute(from, to);
     if (!route_info) return std::nullopt;
 
+    return MakeRouteInfo(route_info->weight, route_info->edges);
+}
+
+RouteInfo TransportRouter::MakeRouteInfo(double weight, const std::vector<graph::EdgeId>& edges) const {
     RouteInfo result;
-    result.total_time = route_info->weight;
-    result.items.reserve(route_info->edges.size() * 2);
+    result.total_time = weight;
+    result.items.reserve(edges.size() * 2);
 
-    for (size_t i = 0; i < route_info->edges.size(); ++i) {
-        auto edge_id = route_info->edges[i];
-        
-        if (auto wait_it = edge_to_wait_item_.find(edge_id); wait_it != edge_to_wait_item_.end()) {
-            result.items.push_back(wait_it->second);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const RouteInfo::Item& item = edge_items_[edges[i]];
+
+        if (i > 0 && std::holds_alternative<RouteInfo::BusItem>(item)
+            && std::holds_alternative<RouteInfo::BusItem>(result.items.back())) {
+            const auto& prev_edge = graph_->GetEdge(edges[i - 1]);
+            result.items.push_back(RouteInfo::WaitItem{
+                vertex_to_stop_[prev_edge.to],
+                static_cast<double>(settings_.bus_wait_time)
+            });
+        }
+        result.items.push_back(item);
+    }
+
+    return result;
+}
+
+TransportRouter::PointSearchState::PointSearchState(size_t vertex_count)
+    : distance(vertex_count)
+    , prev_edge(vertex_count)
+    , reached(vertex_count, 0)
+    , origin(vertex_count) {
+}
+
+TransportRouter::SearchState::SearchState(size_t vertex_count, size_t edge_count)
+    : distance(vertex_count)
+    , prev_edge(vertex_count)
+    , reached(vertex_count, 0)
+    , banned_vertex(vertex_count, 0)
+    , banned_edge(edge_count, 0) {
+}
+
+std::optional<TransportRouter::Path> TransportRouter::FindShortestPath(SearchState& state, graph::VertexId from, graph::VertexId to) const {
+    const unsigned search = ++state.search;
+    const auto by_distance = [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+    };
+
+    state.heap.clear();
+    state.distance[from] = 0;
+    state.reached[from] = search;
+    state.heap.emplace_back(0, from);
+
+    while (!state.heap.empty()) {
+        std::pop_heap(state.heap.begin(), state.heap.end(), by_distance);
+        const auto [distance, vertex] = state.heap.back();
+        state.heap.pop_back();
+
+        if (distance > state.distance[vertex]) {
+            continue;
         }
-        else if (auto bus_it = edge_to_bus_item_.find(edge_id); bus_it != edge_to_bus_item_.end()) {
-            result.items.push_back(bus_it->second);
+        if (vertex == to) {
+            break;
         }
+
+        for (graph::EdgeId edge_id : graph_->GetIncidentEdges(vertex)) {
+            const auto& edge = graph_->GetEdge(edge_id);
+            if (state.banned_edge[edge_id] == state.ban || state.banned_vertex[edge.to] == state.ban) {
+                continue;
+            }
+            const double candidate = distance + edge.weight;
+            if (state.reached[edge.to] != search || candidate < state.distance[edge.to]) {
+                state.reached[edge.to] = search;
+                state.distance[edge.to] = candidate;
+                state.prev_edge[edge.to] = edge_id;
+                state.heap.emplace_back(candidate, edge.to);
+                std::push_heap(state.heap.begin(), state.heap.end(), by_distance);
+            }
+        }
+    }
+
+    if (state.reached[to] != search) {
+        return std::nullopt;
+    }
+
+    Path path{state.distance[to], {}};
+    for (graph::VertexId vertex = to; vertex != from; vertex = graph_->GetEdge(path.edges.back()).from) {
+        path.edges.push_back(state.prev_edge[vertex]);
+    }
+    std::reverse(path.edges.begin(), path.edges.end());
+    return path;
+}
+
+bool TransportRouter::IsSameRide(graph::EdgeId lhs, graph::EdgeId rhs) const {
+    if (lhs == rhs) {
+        return true;
+    }
+    const auto& lhs_edge = graph_->GetEdge(lhs);
+    const auto& rhs_edge = graph_->GetEdge(rhs);
+    const auto* lhs_item = std::get_if<RouteInfo::BusItem>(&edge_items_[lhs]);
+    const auto* rhs_item = std::get_if<RouteInfo::BusItem>(&edge_items_[rhs]);
+    return lhs_edge.from == rhs_edge.from && lhs_edge.to == rhs_edge.to
+        && lhs_item && rhs_item && lhs_item->bus == rhs_item->bus;
+}
+
+void TransportRouter::BanRide(SearchState& state, graph::EdgeId edge_id) const {
+    for (graph::EdgeId other : graph_->GetIncidentEdges(graph_->GetEdge(edge_id).from)) {
+        if (IsSameRide(edge_id, other)) {
+            state.banned_edge[other] = state.ban;
+        }
+    }
+}
+
+std::vector<RouteInfo> TransportRouter::FindAlternativeRoutes(std::string_view from, std::string_view to, size_t count) const {
+    std::vector<RouteInfo> result;
+    auto from_it = stop_to_vertex_wait_.find(from);
+    auto to_it = stop_to_vertex_wait_.find(to);
+    if (from_it == stop_to_vertex_wait_.end() || to_it == stop_to_vertex_wait_.end() || count == 0) {
+        return result;
+    }
+    const graph::VertexId source = from_it->second;
+    const graph::VertexId target = to_it->second;
+    count = std::min(count, MAX_ALTERNATIVES);
+
+    std::vector<Path> found;
+    if (auto route_info = router_->BuildRoute(source, target)) {
+        found.push_back({route_info->weight, std::move(route_info->edges)});
+    } else {
+        return result;
+    }
+
+    SearchState state(graph_->GetVertexCount(), graph_->GetEdgeCount());
+    std::vector<Path> candidates;
+    const auto same_prefix = [this](const std::vector<graph::EdgeId>& lhs, const std::vector<graph::EdgeId>& rhs, size_t length) {
+        return lhs.size() >= length && rhs.size() >= length
+            && std::equal(lhs.begin(), lhs.begin() + length, rhs.begin(),
+                [this](graph::EdgeId l, graph::EdgeId r) { return IsSameRide(l, r); });
+    };
+    const auto is_known = [&](const std::vector<graph::EdgeId>& edges) {
+        const auto same = [&](const Path& path) {
+            return path.edges.size() == edges.size() && same_prefix(path.edges, edges, edges.size());
+        };
+        return std::any_of(found.begin(), found.end(), same)
+            || std::any_of(candidates.begin(), candidates.end(), same);
+    };
+
+    while (found.size() < count) {
+        const std::vector<graph::EdgeId> last = found.back().edges;
+        double root_weight = 0;
+
+        for (size_t i = 0; i < last.size(); ++i) {
+            const graph::VertexId spur = graph_->GetEdge(last[i]).from;
+
+            // Запрещаем продолжения уже найденных маршрутов с тем же началом
+            // и вершины начала, чтобы маршрут остался без циклов
+            ++state.ban;
+            for (const Path& path : found) {
+                if (path.edges.size() > i && same_prefix(last, path.edges, i)) {
+                    BanRide(state, path.edges[i]);
+                }
+            }
+            for (size_t j = 0; j < i; ++j) {
+                state.banned_vertex[graph_->GetEdge(last[j]).from] = state.ban;
+            }
+
+            if (auto spur_path = FindShortestPath(state, spur, target)) {
+                std::vector<graph::EdgeId> edges(last.begin(), last.begin() + i);
+                edges.insert(edges.end(), spur_path->edges.begin(), spur_path->edges.end());
+                if (!is_known(edges)) {
+                    candidates.push_back({root_weight + spur_path->weight, std::move(edges)});
+                }
+            }
+            root_weight += graph_->GetEdge(last[i]).weight;
+        }
+
+        if (candidates.empty()) {
+            break;
+        }
+        auto best = std::min_element(candidates.begin(), candidates.end(),
+            [](const Path& lhs, const Path& rhs) { return lhs.weight < rhs.weight; });
+        found.push_back(std::move(*best));
+        candidates.erase(best);
+    }
+
+    result.reserve(found.size());
+    for (const Path& path : found) {
+        result.push_back(MakeRouteInfo(path.weight, path.edges));
+    }
+    return result;
+}
+
+std::optional<RouteInfo> TransportRouter::FindRouteByDijkstra(std::string_view from, std::string_view to) const {
+    auto from_it = stop_to_vertex_wait_.find(from);
+    auto to_it = stop_to_vertex_wait_.find(to);
+    if (from_it == stop_to_vertex_wait_.end() || to_it == stop_to_vertex_wait_.end()) {
+        return std::nullopt;
+    }
+
+    // Метки запретов сдвинуты, так что ни одно ребро не запрещено
+    SearchState state(graph_->GetVertexCount(), graph_->GetEdgeCount());
+    ++state.ban;
+    auto path = FindShortestPath(state, from_it->second, to_it->second);
+    if (!path) {
+        return std::nullopt;
+    }
+    return MakeRouteInfo(path->weight, path->edges);
+}
+
+std::vector<TransportRouter::Path> TransportRouter::FindParetoPaths(graph::VertexId from, graph::VertexId to, int max_rides) const {
+    const size_t bag_size = static_cast<size_t>(max_rides) + 1;
+    const size_t vertex_count = graph_->GetVertexCount();
+
+    // Сумка вершины v — отрезок [v * bag_size, (v + 1) * bag_size) общих массивов:
+    // лучшее время прибытия и метка для каждого числа поездок
+    const auto state = pareto_states_.Acquire();
+    if (state->best_time.size() < vertex_count * bag_size) {
+        state->best_time.resize(vertex_count * bag_size, std::numeric_limits<double>::infinity());
+        state->best_label.resize(vertex_count * bag_size, NO_LABEL);
     }
+    std::vector<double>& best_time = state->best_time;
+    std::vector<uint32_t>& best_label = state->best_label;
+    std::vector<Label>& labels = state->labels;
+    std::vector<std::pair<double, uint32_t>>& heap = state->heap;
+    labels.clear();
+    heap.clear();
+
+    const auto by_time = [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+    };
+    const auto is_dominated = [&](graph::VertexId vertex, uint32_t rides, double time) {
+        const double* bag = &best_time[vertex * bag_size];
+        for (uint32_t r = 0; r <= rides; ++r) {
+            if (bag[r] <= time) {
+                return true;
+            }
+        }
+        return false;
+    };
 
-    for (size_t i = 1; i < result.items.size(); ++i) {
-        if (holds_alternative<RouteInfo::BusItem>(result.items[i-1]) &&
-            holds_alternative<RouteInfo::BusItem>(result.items[i])) {
-            
-            const auto& prev_edge = graph_->GetEdge(route_info->edges[i-1]);
-            const std::string& stop_name = vertex_to_stop_.at(prev_edge.to);
-            
-            result.items.insert(
-                result.items.begin() + i,
-                RouteInfo::WaitItem{stop_name, static_cast<double>(settings_.bus_wait_time)}
-            );
-            ++i;
+    labels.push_back({0, 0, NO_LABEL, static_cast<uint32_t>(from), NO_LABEL});
+    best_time[from * bag_size] = 0;
+    best_label[from * bag_size] = 0;
+    heap.emplace_back(0, 0);
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), by_time);
+        const uint32_t label_id = heap.back().second;
+        heap.pop_back();
+
+        const Label label = labels[label_id];
+        if (best_label[label.vertex * bag_size + label.rides] != label_id || label.vertex == to) {
+            continue;
+        }
+
+        for (graph::EdgeId edge_id : graph_->GetIncidentEdges(label.vertex)) {
+            const auto& edge = graph_->GetEdge(edge_id);
+            const uint32_t rides = label.rides + (std::holds_alternative<RouteInfo::BusItem>(edge_items_[edge_id]) ? 1 : 0);
+            const double time = label.time + edge.weight;
+            if (rides >= bag_size || is_dominated(edge.to, rides, time)) {
+                continue;
+            }
+            const auto new_label = static_cast<uint32_t>(labels.size());
+            labels.push_back({time, rides, label_id, static_cast<uint32_t>(edge.to), static_cast<uint32_t>(edge_id)});
+            best_time[edge.to * bag_size + rides] = time;
+            best_label[edge.to * bag_size + rides] = new_label;
+            heap.emplace_back(time, new_label);
+            std::push_heap(heap.begin(), heap.end(), by_time);
         }
     }
 
+    std::vector<Path> result;
+    double best_so_far = std::numeric_limits<double>::infinity();
+    for (size_t rides = 0; rides < bag_size; ++rides) {
+        const uint32_t label_id = best_label[to * bag_size + rides];
+        if (label_id == NO_LABEL || labels[label_id].time >= best_so_far) {
+            continue;
+        }
+        best_so_far = labels[label_id].time;
+
+        Path path{best_so_far, {}};
+        for (uint32_t id = label_id; labels[id].parent != NO_LABEL; id = labels[id].parent) {
+            path.edges.push_back(labels[id].edge);
+        }
+        std::reverse(path.edges.begin(), path.edges.end());
+        result.push_back(std::move(path));
+    }
+
+    for (const Label& label : labels) {
+        best_time[label.vertex * bag_size + label.rides] = std::numeric_limits<double>::infinity();
+        best_label[label.vertex * bag_size + label.rides] = NO_LABEL;
+    }
     return result;
 }
 
+std::vector<RouteInfo> TransportRouter::FindParetoRoutes(std::string_view from, std::string_view to, int max_transfers) const {
+    std::vector<RouteInfo> result;
+    auto from_it = stop_to_vertex_wait_.find(from);
+    auto to_it = stop_to_vertex_wait_.find(to);
+    if (from_it == stop_to_vertex_wait_.end() || to_it == stop_to_vertex_wait_.end() || max_transfers < 0) {
+        return result;
+    }
+
+    const auto paths = FindParetoPaths(from_it->second, to_it->second, std::min(max_transfers, MAX_TRANSFERS) + 1);
+    result.reserve(paths.size());
+    for (const Path& path : paths) {
+        result.push_back(MakeRouteInfo(path.weight, path.edges));
+    }
+    return result;
+}
+
+std::optional<RouteInfo> TransportRouter::FindFewestTransfersRoute(std::string_view from, std::string_view to,
+                                                                   int max_transfers, double time_slack) const {
+    auto routes = FindParetoRoutes(from, to, max_transfers);
+    if (routes.empty()) {
+        return std::nullopt;
+    }
+    const double time_limit = routes.back().total_time * (1 + time_slack);
+    for (auto& route : routes) {
+        if (route.total_time <= time_limit) {
+            return std::move(route);
+        }
+    }
+    return std::move(routes.back());
+}
+
 } // namespace transport
@@ -4,8 +4,12 @@
 #include "graph.h"
 #include "router.h"
 #include "transport_catalogue.h"
+#include "stop_index.h"
 
+#include <cstdint>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string_view>
 #include <unordered_map>
@@ -14,28 +18,129 @@
 
 namespace transport {
 
+// Буферы поиска, переиспользуемые между запросами. Поток берёт свободный
+// экземпляр на время поиска и возвращает его, так что параллельные запросы
+// не делят буферы, а последовательные не выделяют память заново
+template <typename State>
+class StatePool {
+public:
+    class Lease {
+    public:
+        Lease(StatePool& pool, std::unique_ptr<State> state) : pool_(pool), state_(std::move(state)) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() {
+            pool_.Release(std::move(state_));
+        }
+
+        State& operator*() const { return *state_; }
+        State* operator->() const { return state_.get(); }
+
+    private:
+        StatePool& pool_;
+        std::unique_ptr<State> state_;
+    };
+
+    // Новый экземпляр создаётся из args, только если свободных нет
+    template <typename... Args>
+    Lease Acquire(Args&&... args) {
+        {
+            std::lock_guard lock(mutex_);
+            if (!free_.empty()) {
+                std::unique_ptr<State> state = std::move(free_.back());
+                free_.pop_back();
+                return Lease(*this, std::move(state));
+            }
+        }
+        return Lease(*this, std::make_unique<State>(std::forward<Args>(args)...));
+    }
+
+private:
+    void Release(std::unique_ptr<State> state) {
+        std::lock_guard lock(mutex_);
+        free_.push_back(std::move(state));
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<State>> free_;
+};
+
 struct RoutingSettings {
     int bus_wait_time;      
     double bus_velocity;   
+    size_t route_cache_size = 1024;
+    // Для маршрутов между произвольными точками: скорость пешехода в км/ч
+    // и наибольшее расстояние в метрах, на которое идут пешком до остановки
+    double walking_velocity = 5.0;
+    double max_walking_distance = 1000.0;
 };
 
+// Элементы ссылаются на остановки и автобусы справочника,
+// имена подставляются только при выводе ответа
 struct RouteInfo {
     struct WaitItem {
-        std::string stop_name;
+        const Stop* stop;
         double time;
     };
 
     struct BusItem {
-        std::string bus_name;
+        const Bus* bus;
         int span_count;    
         double time;       
     };
 
-    using Item = std::variant<WaitItem, BusItem>;
+    // Пешком от точки до остановки, от остановки до точки или между точками;
+    // nullptr — точка из запроса
+    struct WalkItem {
+        const Stop* from;
+        const Stop* to;
+        double time;
+    };
+
+    using Item = std::variant<WaitItem, BusItem, WalkItem>;
     std::vector<Item> items;  
     double total_time;        
+
+    int GetTransferCount() const;
+};
+
+struct RouteCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
 };
 
+// Потокобезопасный LRU-кэш готовых ответов по паре вершин (from, to).
+// Живёт вместе с роутером, поэтому не сбрасывается: граф роутера не меняется
+class RouteCache {
+public:
+    using Key = std::pair<graph::VertexId, graph::VertexId>;
+    using Value = std::optional<RouteInfo>;
+
+    explicit RouteCache(size_t capacity);
+
+    std::optional<Value> Get(Key key);
+    void Put(Key key, Value value);
+
+    RouteCacheStats GetStats() const;
+
+private:
+    struct KeyHasher {
+        size_t operator()(Key key) const {
+            return hasher_(key.first) + hasher_(key.second) * 37;
+        }
+    private:
+        std::hash<graph::VertexId> hasher_;
+    };
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::list<std::pair<Key, Value>> entries_;
+    std::unordered_map<Key, std::list<std::pair<Key, Value>>::iterator, KeyHasher> positions_;
+    RouteCacheStats stats_;
+};
+
+// Граф строится по снимку справочника и после его изменения не обновляется:
+// владелец строит роутер заново, когда меняется TransportCatalogue::GetVersion
 class TransportRouter {
 public:
     TransportRouter(const TransportCatalogue& catalogue, const RoutingSettings& settings);
@@ -45,15 +150,107 @@ public:
 
     std::optional<RouteInfo> FindRoute(std::string_view from, std::string_view to) const;
 
+    // Маршрут между точками: пешком до остановок в пределах max_walking_distance,
+    // затем по графу, либо целиком пешком, если точки не дальше max_walking_distance.
+    // Пешие рёбра виртуальные, граф не меняется
+    std::optional<RouteInfo> FindRoute(geo::Coordinates from, geo::Coordinates to, const StopIndex& stops) const;
+
+    // До count маршрутов без циклов в порядке возрастания времени (алгоритм Йена).
+    // count больше MAX_ALTERNATIVES считается равным MAX_ALTERNATIVES
+    std::vector<RouteInfo> FindAlternativeRoutes(std::string_view from, std::string_view to, size_t count) const;
+
+    // Один поиск Дейкстры по графу, без предрасчитанных маршрутов и кэша.
+    // Столько стоит каждое ответвление в FindAlternativeRoutes
+    std::optional<RouteInfo> FindRouteByDijkstra(std::string_view from, std::string_view to) const;
+
+    // Парето-оптимальные по (время, пересадки) маршруты, не больше max_transfers пересадок.
+    // Отсортированы по возрастанию числа пересадок, то есть по убыванию времени
+    // max_transfers больше MAX_TRANSFERS считается равным MAX_TRANSFERS
+    std::vector<RouteInfo> FindParetoRoutes(std::string_view from, std::string_view to, int max_transfers) const;
+
+    // Маршрут с минимумом пересадок среди тех, что не дольше самого быстрого
+    // более чем в (1 + time_slack) раз
+    std::optional<RouteInfo> FindFewestTransfersRoute(std::string_view from, std::string_view to,
+                                                      int max_transfers, double time_slack) const;
+
+    RouteCacheStats GetCacheStats() const;
+
+    // Память многокритериального поиска растёт как число вершин на число пересадок
+    static constexpr int MAX_TRANSFERS = 16;
+    // Каждый следующий маршрут стоит поиска от каждой вершины предыдущего
+    static constexpr size_t MAX_ALTERNATIVES = 16;
+
 private:
+    struct Path {
+        double weight;
+        std::vector<graph::EdgeId> edges;
+    };
+
+    // Буферы Дейкстры, переиспользуемые между поисками одного запроса.
+    // Метки поколений позволяют не очищать массивы перед каждым поиском
+    struct SearchState {
+        SearchState(size_t vertex_count, size_t edge_count);
+
+        std::vector<double> distance;
+        std::vector<graph::EdgeId> prev_edge;
+        std::vector<unsigned> reached;
+        std::vector<unsigned> banned_vertex;
+        std::vector<unsigned> banned_edge;
+        std::vector<std::pair<double, graph::VertexId>> heap;
+        unsigned search = 0;
+        unsigned ban = 0;
+    };
+
+    // Буферы поиска между точками: как SearchState, но без запретов.
+    // Берутся из пула, так что запрос не выделяет массивы по числу вершин
+    struct PointSearchState {
+        explicit PointSearchState(size_t vertex_count);
+
+        std::vector<double> distance;
+        std::vector<graph::EdgeId> prev_edge;
+        std::vector<unsigned> reached;
+        // Остановка у начальной точки, с которой начался путь до вершины
+        std::vector<graph::VertexId> origin;
+        std::vector<std::pair<double, graph::VertexId>> heap;
+        unsigned search = 0;
+    };
+
+    // Метка многокритериального поиска, хранится в общем массиве-арене
+    struct Label {
+        double time;
+        uint32_t rides;
+        uint32_t parent;
+        uint32_t vertex;
+        uint32_t edge;
+    };
+
+    // Арены многокритериального поиска. Между поисками best_time и best_label
+    // чисты: после поиска сбрасываются только записанные метками ячейки
+    struct ParetoState {
+        std::vector<double> best_time;
+        std::vector<uint32_t> best_label;
+        std::vector<Label> labels;
+        std::vector<std::pair<double, uint32_t>> heap;
+    };
+
+    std::vector<Path> FindParetoPaths(graph::VertexId from, graph::VertexId to, int max_rides) const;
+
+    std::optional<RouteInfo> BuildRouteInfo(graph::VertexId from, graph::VertexId to) const;
+    RouteInfo MakeRouteInfo(double weight, const std::vector<graph::EdgeId>& edges) const;
+    std::optional<Path> FindShortestPath(SearchState& state, graph::VertexId from, graph::VertexId to) const;
+    // Параллельные рёбра одного автобуса неотличимы для пассажира
+    bool IsSameRide(graph::EdgeId lhs, graph::EdgeId rhs) const;
+    void BanRide(SearchState& state, graph::EdgeId edge_id) const;
+
     void BuildGraph();
     void InitializeStopVertices();
     void AddWaitEdges();
     void AddBusEdges();
-    void AddBusEdgesForDirection(const Bus& bus, const std::vector<const Stop*>& stops, bool forward);
-    void AddBusEdge(const Bus& bus, size_t from_idx, size_t to_idx, int distance);
+    void AddBusEdgesForRoute(const Bus& bus, const RouteTraversal<StopId>& stops);
+    void AddBusEdge(const Bus& bus, const RouteTraversal<StopId>& stops, size_t from_idx, size_t to_idx, int distance);
     
     double ComputeBusTime(int distance) const;
+    double ComputeWalkTime(double distance) const;
 
     const TransportCatalogue& catalogue_;
     const RoutingSettings settings_;
@@ -63,10 +260,14 @@ private:
 
     std::unordered_map<std::string_view, graph::VertexId> stop_to_vertex_wait_;  
     std::unordered_map<std::string_view, graph::VertexId> stop_to_vertex_bus_;   
-    std::unordered_map<graph::VertexId, std::string> vertex_to_stop_;
+    std::vector<const Stop*> vertex_to_stop_;
+
+    // Индекс в векторе совпадает с EdgeId
+    std::vector<RouteInfo::Item> edge_items_;
 
-    std::unordered_map<graph::EdgeId, RouteInfo::WaitItem> edge_to_wait_item_;
-    std::unordered_map<graph::EdgeId, RouteInfo::BusItem> edge_to_bus_item_;
+    mutable RouteCache cache_;
+    mutable StatePool<PointSearchState> point_states_;
+    mutable StatePool<ParetoState> pareto_states_;
 };
 
 } // namespace transport